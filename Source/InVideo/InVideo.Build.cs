@@ -38,6 +38,7 @@ public class InVideo : ModuleRules
       {
 				// ... add private dependencies that you statically link with here ...	
 				"InOpenCV",
+        "InVideoShaders",
         "UMG",
         "CoreUObject",
         "Engine",
@@ -2,47 +2,258 @@
 
 
 #include "InRecordGameViewportClient.h"
-#include "Slate/SceneViewport.h"
+#include "Async/Async.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+#include "UnrealClient.h"
 
+/**
+ * 回读环：槽位按提交顺序循环使用，只在渲染线程访问（计数除外）。
+ * 采集把视口纹理拷贝到 Head 槽位的暂存区，轮询从 Tail 开始按顺序取出已完成的帧，保证交付顺序与采集顺序一致。
+ */
+struct FInRecordReadbackRing
+{
+	struct FSlot
+	{
+		TUniquePtr<FRHIGPUTextureReadback> Readback;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		EPixelFormat Format = PF_Unknown;
+		uint32 Generation = 0;
+		int32 Downscale = 0;
+		double CaptureSeconds = 0.0;
+	};
+
+	FSlot Slots[UInRecordGameViewportClient::MaxFramesInFlight];
+	int32 Tail = 0;
+	int32 Count = 0;
+	bool bWarnedFormat = false;
+	TAtomic<int32> Captured{ 0 };
+	// 所有槽位都在途而跳过的采集
+	TAtomic<int32> Dropped{ 0 };
+	// 帧池耗尽（编码跟不上）而丢弃的帧
+	TAtomic<int32> Starved{ 0 };
+
+	void Capture_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture* Source, FIntPoint Size, uint32 Generation,
+		int32 Downscale, double CaptureSeconds)
+	{
+		if (nullptr == Source)
+		{
+			return;
+		}
+		if (Count >= UInRecordGameViewportClient::MaxFramesInFlight)
+		{
+			++Dropped;
+			return;
+		}
+		const FIntVector SourceSize = Source->GetSizeXYZ();
+		Size.X = FMath::Min(Size.X, SourceSize.X);
+		Size.Y = FMath::Min(Size.Y, SourceSize.Y);
+		if (Size.X <= 0 || Size.Y <= 0)
+		{
+			return;
+		}
 
-void UInRecordGameViewportClient::StartRecord(const int Fps)
+		FSlot& Slot = Slots[(Tail + Count) % UInRecordGameViewportClient::MaxFramesInFlight];
+		if (!Slot.Readback.IsValid())
+		{
+			Slot.Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("InRecordCapture"));
+		}
+		Slot.Size = Size;
+		Slot.Format = Source->GetFormat();
+		Slot.Generation = Generation;
+		Slot.Downscale = Downscale;
+		Slot.CaptureSeconds = CaptureSeconds;
+
+		RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+		Slot.Readback->EnqueueCopy(RHICmdList, Source, FResolveRect(0, 0, Size.X, Size.Y));
+		// 之后 Slate 继续把视口当作渲染目标绘制
+		RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::CopySrc, ERHIAccess::RTV));
+		++Count;
+		++Captured;
+	}
+
+	// 取出已完成的帧，遇到未完成的槽位即停止，不等待 GPU
+	template <typename DeliverType>
+	void Poll_RenderThread(TInVideoBufferPool<FInRecordFrame>& FramePool, DeliverType&& Deliver)
+	{
+		while (Count > 0)
+		{
+			FSlot& Slot = Slots[Tail];
+			if (!Slot.Readback->IsReady())
+			{
+				break;
+			}
+			FInRecordFrameRef Frame = FramePool.Acquire();
+			if (!Frame.IsValid())
+			{
+				++Starved;
+			}
+			else if (ReadSlot(Slot, *Frame))
+			{
+				Deliver(MoveTemp(Frame), Slot.Generation);
+			}
+			Tail = (Tail + 1) % UInRecordGameViewportClient::MaxFramesInFlight;
+			--Count;
+		}
+	}
+
+	bool ReadSlot(FSlot& Slot, FInRecordFrame& OutFrame)
+	{
+		if (PF_B8G8R8A8 != Slot.Format && PF_R8G8B8A8 != Slot.Format && PF_A2B10G10R10 != Slot.Format)
+		{
+			if (!bWarnedFormat)
+			{
+				bWarnedFormat = true;
+				UE_LOG(LogTemp, Warning, TEXT("InRecord: unsupported viewport format %s, frames dropped"), GetPixelFormatString(Slot.Format));
+			}
+			return false;
+		}
+
+		int32 RowPitchInPixels = 0;
+		const uint8* Data = static_cast<const uint8*>(Slot.Readback->Lock(RowPitchInPixels));
+		if (nullptr == Data)
+		{
+			return false;
+		}
+		// 缩小采集时隔 Step 行、Step 列取一个像素
+		const int32 Step = 1 << Slot.Downscale;
+		const int32 Width = Slot.Size.X / Step;
+		const int32 Height = Slot.Size.Y / Step;
+		if (Width <= 0 || Height <= 0)
+		{
+			Slot.Readback->Unlock();
+			return false;
+		}
+		// 复用的帧不缩小容量，稳态下不分配内存
+		OutFrame.Pixels.SetNumUninitialized(Width * Height, false);
+		OutFrame.Width = Width;
+		OutFrame.Height = Height;
+		OutFrame.SourceWidth = Slot.Size.X;
+		OutFrame.SourceHeight = Slot.Size.Y;
+		OutFrame.CaptureSeconds = Slot.CaptureSeconds;
+		FColor* Dest = OutFrame.Pixels.GetData();
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			const uint8* Row = Data + (int64)Y * Step * RowPitchInPixels * 4;
+			FColor* DestRow = Dest + (int64)Y * Width;
+			if (PF_B8G8R8A8 == Slot.Format && 1 == Step)
+			{
+				// FColor 即 BGRA 排列，直接拷贝
+				FMemory::Memcpy(DestRow, Row, (SIZE_T)Width * 4);
+			}
+			else if (PF_B8G8R8A8 == Slot.Format)
+			{
+				const FColor* Src = reinterpret_cast<const FColor*>(Row);
+				for (int32 X = 0; X < Width; ++X)
+				{
+					DestRow[X] = Src[X * Step];
+				}
+			}
+			else if (PF_R8G8B8A8 == Slot.Format)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const uint8* Src = Row + X * Step * 4;
+					DestRow[X] = FColor(Src[0], Src[1], Src[2], Src[3]);
+				}
+			}
+			else
+			{
+				const uint32* Src = reinterpret_cast<const uint32*>(Row);
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const uint32 Packed = Src[X * Step];
+					DestRow[X] = FColor((Packed >> 2) & 0xFF, (Packed >> 12) & 0xFF, (Packed >> 22) & 0xFF, 0xFF);
+				}
+			}
+		}
+		Slot.Readback->Unlock();
+		return true;
+	}
+};
+
+void UInRecordGameViewportClient::StartRecord(const int Fps, int32 FramePoolSize)
 {
 	m_CanRecord = true;
 	m_FpsInterval = 1000.0 / Fps;
-	m_LastTime = FDateTime::Now().GetTimeOfDay().GetTotalMilliseconds();
+	m_LastTime = FPlatformTime::Seconds() * 1000.0;
+	++m_RecordGeneration;
+	if (!m_ReadbackRing.IsValid())
+	{
+		m_ReadbackRing = MakeShared<FInRecordReadbackRing, ESPMode::ThreadSafe>();
+	}
+	m_CaptureDownscale = 0;
+	FramePoolSize = FMath::Max(1, FramePoolSize);
+	if (!m_FramePool.IsValid() || m_FramePoolSize != FramePoolSize)
+	{
+		// 旧池中未归还的帧在最后一次释放时直接删除
+		m_FramePool = TInVideoBufferPool<FInRecordFrame>::Create(FramePoolSize);
+		m_FramePoolSize = FramePoolSize;
+	}
+	m_ReadbackRing->Captured = 0;
+	m_ReadbackRing->Dropped = 0;
+	m_ReadbackRing->Starved = 0;
 }
 
 void UInRecordGameViewportClient::StopRecord()
 {
+	if (m_CanRecord && m_ReadbackRing.IsValid())
+	{
+		UE_LOG(LogTemp, Log, TEXT("InRecord: captured %d frames, dropped %d (all readbacks in flight), %d (frame pool exhausted)"),
+			m_ReadbackRing->Captured.Load(), m_ReadbackRing->Dropped.Load(), m_ReadbackRing->Starved.Load());
+	}
 	m_CanRecord = false;
+	// 在途的回读完成后按代号丢弃
+	++m_RecordGeneration;
+}
+
+void UInRecordGameViewportClient::SetCaptureDownscale(int32 Level)
+{
+	m_CaptureDownscale = FMath::Clamp(Level, 0, MaxCaptureDownscale);
+}
+
+int32 UInRecordGameViewportClient::GetCaptureDroppedFrames() const
+{
+	return m_ReadbackRing.IsValid() ? m_ReadbackRing->Dropped.Load() + m_ReadbackRing->Starved.Load() : 0;
 }
 
 void UInRecordGameViewportClient::Draw(FViewport* InViewport, FCanvas* SceneCanvas)
 {
 	Super::Draw(InViewport, SceneCanvas);
 
-	if (false == m_CanRecord)
+	if (false == m_CanRecord || nullptr == InViewport)
 	{
 		return;
 	}
 
-	auto nowTime = FDateTime::Now().GetTimeOfDay().GetTotalMilliseconds();
-	if ((nowTime - m_LastTime) < m_FpsInterval)
+	const double NowTime = FPlatformTime::Seconds() * 1000.0;
+	const bool bCapture = (NowTime - m_LastTime) >= m_FpsInterval;
+	if (bCapture)
 	{
-		return;
+		m_LastTime = NowTime;
 	}
-	m_LastTime = nowTime;
-
-	auto SceneViewport = GetGameViewport();
-
-	TArray<FColor> Bitmap;
-	int BitmapX = InViewport->GetSizeXY().X;
-	int BitmapY = InViewport->GetSizeXY().Y;
 
-	auto ReadRet = SceneViewport->ReadPixels(Bitmap, FReadSurfaceDataFlags());
-	if (false == ReadRet)
-	{
-		return;
-	}
-	OnFrameData.ExecuteIfBound(Bitmap, BitmapX, BitmapY);
-}
\ No newline at end of file
+	// 每帧都发命令轮询在途的回读；游戏线程只做入队
+	ENQUEUE_RENDER_COMMAND(InRecordCapture)(
+		[Ring = m_ReadbackRing, FramePool = m_FramePool, Viewport = InViewport, Size = InViewport->GetSizeXY(), bCapture,
+		Generation = m_RecordGeneration, Downscale = m_CaptureDownscale, NowSeconds = NowTime / 1000.0, WeakThis = TWeakObjectPtr<UInRecordGameViewportClient>(this)](FRHICommandListImmediate& RHICmdList)
+		{
+			Ring->Poll_RenderThread(*FramePool, [&WeakThis](FInRecordFrameRef&& Frame, uint32 FrameGeneration)
+				{
+					AsyncTask(ENamedThreads::GameThread, [WeakThis, Frame = MoveTemp(Frame), FrameGeneration]() mutable
+						{
+							UInRecordGameViewportClient* Client = WeakThis.Get();
+							if (nullptr == Client || !Client->m_CanRecord || Client->m_RecordGeneration != FrameGeneration)
+							{
+								return;
+							}
+							Client->OnFrameData.ExecuteIfBound(MoveTemp(Frame));
+						});
+				});
+			if (bCapture)
+			{
+				// BeginRenderFrame 之后视口的渲染目标即本帧的后台缓冲
+				Ring->Capture_RenderThread(RHICmdList, Viewport->GetRenderTargetTexture(), Size, Generation, Downscale, NowSeconds);
+			}
+		});
+}
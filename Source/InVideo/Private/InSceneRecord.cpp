@@ -3,6 +3,8 @@
 
 #include "InSceneRecord.h"
 #include "InRecordGameViewportClient.h"
+#include "InVideoPixelConvert.h"
+#include "Misc/ScopeLock.h"
 
 #include <string>
 
@@ -58,17 +60,28 @@ void AInSceneRecord::StartRecord(const FString FilePath, const int Fps)
 	}
 	ViewPortClient->OnFrameData.BindUObject(this, &AInSceneRecord::HandleFrameData);
 
-	if (nullptr != m_ImageBuf)
-	{
-		delete[] m_ImageBuf;
-		m_ImageBuf = nullptr;
-	}
+	m_ImageX = 0;
+	m_ImageY = 0;
+	m_Stopping = false;
 	if (nullptr == m_WrapOpenCv)
 	{
 		m_WrapOpenCv = new WrapOpenCv();
 	}
+	m_WrapOpenCv->m_ImageQueue.Reset(QueueDepth, EInRecordQueuePolicy::DropOldest == QueuePolicy ?
+		EInVideoQueueFullPolicy::DropOldest : EInVideoQueueFullPolicy::Block);
 
-	ViewPortClient->StartRecord(Fps);
+	m_ViewportClient = ViewPortClient;
+	m_DownscaleLevel = 0;
+	m_EmptyStreak = 0;
+	m_DroppedFrames = 0;
+	m_EncodedFrames = 0;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_LastEncodeLagMs = 0.0f;
+		m_MaxEncodeLagMs = 0.0f;
+	}
+	// 队列中的帧、在途回读和编码线程手上的一帧都来自帧池，池大小即采集内存上限
+	ViewPortClient->StartRecord(Fps, QueueDepth + UInRecordGameViewportClient::MaxFramesInFlight + 1);
 }
 
 void AInSceneRecord::StoptRecord()
@@ -93,7 +106,8 @@ void AInSceneRecord::StoptRecord()
 	}
 	m_IsRecording = false;
 
-	m_Stopping = true;
+	// 唤醒编码线程，Kill 等待它把剩余的帧写完
+	Stop();
 	if (nullptr != m_Thread)
 	{
 		m_Thread->Kill();
@@ -101,13 +115,8 @@ void AInSceneRecord::StoptRecord()
 		m_Thread = nullptr;
 	}
 
-	if (nullptr != m_ImageBuf)
-	{
-		delete[] m_ImageBuf;
-		m_ImageBuf = nullptr;
-	}
-	m_WrapOpenCv->m_VideoWriter.release();
-
+	UE_LOG(LogTemp, Log, TEXT("AInSceneRecord StoptRecord encoded=%d dropped=%d maxLagMs=%.1f"),
+		m_EncodedFrames.Load(), m_DroppedFrames.Load(), m_MaxEncodeLagMs);
 	if (nullptr != m_WrapOpenCv)
 	{
 		m_WrapOpenCv->m_VideoWriter.release();
@@ -116,10 +125,16 @@ void AInSceneRecord::StoptRecord()
 	}
 }
 
-void AInSceneRecord::HandleFrameData(TArray<FColor> Bitmap, int32 x, int32 y)
+void AInSceneRecord::HandleFrameData(FInRecordFrameRef&& Frame)
 {
-	int length = Bitmap.Num() * 3;
-	if (nullptr != m_ImageBuf)
+	if (!Frame.IsValid() || nullptr == m_WrapOpenCv)
+	{
+		return;
+	}
+	// 缩小采集的帧按原始视口尺寸校验，编码时放大回来
+	const int32 x = Frame->SourceWidth;
+	const int32 y = Frame->SourceHeight;
+	if (0 != m_ImageX)
 	{
 		if (m_ImageX != x || m_ImageY != y)
 		{
@@ -127,17 +142,17 @@ void AInSceneRecord::HandleFrameData(TArray<FColor> Bitmap, int32 x, int32 y)
 			return;
 		}
 	}
-	if (nullptr == m_ImageBuf)
+	if (0 == m_ImageX)
 	{
 		UE_LOG(LogTemp, Log, TEXT("AInSceneRecord HandleFrameData x=%d y=%d"), x,y);
 
-		m_ImageBuf = new char[length];
 		m_ImageX = x;
 		m_ImageY = y;
 		std::string cvFilePath(TCHAR_TO_UTF8(*m_FilePath));
 
+		m_WrapOpenCv->m_OutputSize = cv::Size(m_ImageX, m_ImageY);
 		m_WrapOpenCv->m_VideoWriter.release();
-		m_WrapOpenCv->m_VideoWriter.open(cvFilePath, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), m_Fps, cv::Size(m_ImageX, m_ImageY));
+		m_WrapOpenCv->m_VideoWriter.open(cvFilePath, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), m_Fps, m_WrapOpenCv->m_OutputSize);
 	}
 
 	if (false == m_WrapOpenCv->m_VideoWriter.isOpened())
@@ -151,7 +166,112 @@ void AInSceneRecord::HandleFrameData(TArray<FColor> Bitmap, int32 x, int32 y)
 		m_Thread = FRunnableThread::Create(this, TEXT("SceneRecord Thread"));
 	}
 
-	m_WrapOpenCv->m_ImageQueue.Enqueue(Bitmap);
+	EnqueueFrame(Frame);
+}
+
+bool AInSceneRecord::EnqueueFrame(FInRecordFrameRef& Frame)
+{
+	TInVideoRing<FInRecordFrameRef>& Queue = m_WrapOpenCv->m_ImageQueue;
+	bool bQueued = false;
+	switch (QueuePolicy)
+	{
+	case EInRecordQueuePolicy::BlockCapture:
+		bQueued = Queue.Push(Frame, m_Stopping);
+		break;
+	case EInRecordQueuePolicy::DropOldest:
+	{
+		const uint32 DroppedBefore = Queue.GetDroppedCount();
+		bQueued = Queue.TryPush(Frame);
+		if (Queue.GetDroppedCount() != DroppedBefore)
+		{
+			// 换回的是被挤掉的最旧帧
+			++m_DroppedFrames;
+			INC_DWORD_STAT(STAT_InVideo_RecordDropped);
+		}
+		break;
+	}
+	default:
+		bQueued = Queue.TryPush(Frame);
+		break;
+	}
+	if (!bQueued)
+	{
+		++m_DroppedFrames;
+		INC_DWORD_STAT(STAT_InVideo_RecordDropped);
+	}
+	if (EInRecordQueuePolicy::DegradeResolution == QueuePolicy)
+	{
+		UpdateDownscale(!bQueued);
+	}
+	// 未入队的新帧或被挤掉的旧帧在这里回到帧池
+	Frame.Reset();
+	SET_DWORD_STAT(STAT_InVideo_RecordQueueDepth, Queue.Num());
+	return bQueued;
+}
+
+void AInSceneRecord::UpdateDownscale(bool bQueueFull)
+{
+	UInRecordGameViewportClient* ViewPortClient = m_ViewportClient.Get();
+	if (nullptr == ViewPortClient)
+	{
+		return;
+	}
+	int32 Level = m_DownscaleLevel;
+	if (bQueueFull)
+	{
+		m_EmptyStreak = 0;
+		Level = FMath::Min(Level + 1, UInRecordGameViewportClient::MaxCaptureDownscale);
+	}
+	else if (m_WrapOpenCv->m_ImageQueue.Num() <= 1)
+	{
+		// 编码持续跟得上（约 2 秒队列里最多只有刚放入的一帧）才恢复一级
+		if (++m_EmptyStreak >= FMath::Max(1, m_Fps) * 2 && Level > 0)
+		{
+			m_EmptyStreak = 0;
+			--Level;
+		}
+	}
+	else
+	{
+		m_EmptyStreak = 0;
+	}
+	if (Level != m_DownscaleLevel)
+	{
+		UE_LOG(LogTemp, Log, TEXT("AInSceneRecord capture downscale %d -> %d"), m_DownscaleLevel, Level);
+		m_DownscaleLevel = Level;
+		ViewPortClient->SetCaptureDownscale(Level);
+	}
+}
+
+void AInSceneRecord::RecordEncoded(double CaptureSeconds)
+{
+	++m_EncodedFrames;
+	const float LagMs = (float)((FPlatformTime::Seconds() - CaptureSeconds) * 1000.0);
+	SET_FLOAT_STAT(STAT_InVideo_RecordEncodeLagMs, LagMs);
+	FScopeLock Lock(&m_StatsMutex);
+	m_LastEncodeLagMs = LagMs;
+	m_MaxEncodeLagMs = FMath::Max(m_MaxEncodeLagMs, LagMs);
+}
+
+FInRecordStats AInSceneRecord::GetRecordStats() const
+{
+	FInRecordStats Stats;
+	if (nullptr != m_WrapOpenCv)
+	{
+		Stats.QueueDepth = m_WrapOpenCv->m_ImageQueue.Num();
+		Stats.QueueCapacity = m_WrapOpenCv->m_ImageQueue.Capacity();
+	}
+	Stats.EncodedFrames = m_EncodedFrames.Load();
+	Stats.DroppedFrames = m_DroppedFrames.Load();
+	if (const UInRecordGameViewportClient* ViewPortClient = m_ViewportClient.Get())
+	{
+		Stats.CaptureDroppedFrames = ViewPortClient->GetCaptureDroppedFrames();
+	}
+	Stats.DownscaleLevel = m_DownscaleLevel;
+	FScopeLock Lock(&m_StatsMutex);
+	Stats.LastEncodeLagMs = m_LastEncodeLagMs;
+	Stats.MaxEncodeLagMs = m_MaxEncodeLagMs;
+	return Stats;
 }
 
 bool AInSceneRecord::Init()
@@ -160,39 +280,65 @@ bool AInSceneRecord::Init()
 }
 uint32 AInSceneRecord::Run()
 {
-	float SleepSecond = 1 / 50;
 	UE_LOG(LogTemp, Log, TEXT("AInSceneRecord open Enter"));
 	while (false == m_Stopping)
 	{
-		if (false == m_WrapOpenCv->m_ImageQueue.IsEmpty())
+		// 入队时触发事件，空闲时线程挂起；超时只用于兜底检查停止标志
+		if (m_WrapOpenCv->m_ImageQueue.WaitNotEmpty(RecordWaitMs))
 		{
-			TArray<FColor> Bitmap;
-			m_WrapOpenCv->m_ImageQueue.Dequeue(Bitmap);
-
-			int count = 0;
-			for (int i = 0; i < Bitmap.Num(); i++)
-			{
-				m_ImageBuf[count] = Bitmap[i].B;
-				m_ImageBuf[count + 1] = Bitmap[i].G;
-				m_ImageBuf[count + 2] = Bitmap[i].R;
-				count += 3;
-			}
-
-			cv::Mat img(m_ImageY, m_ImageX, CV_8UC3, (unsigned char*)m_ImageBuf);
-
-			m_WrapOpenCv->m_VideoWriter.write(img);
-			continue;
+			DrainQueue();
 		}
-		FPlatformProcess::Sleep(SleepSecond);
 	}
+	// 停止前把已入队的帧写完，文件结尾不丢帧
+	DrainQueue();
 	UE_LOG(LogTemp, Log, TEXT("AInSceneRecord Run END"));
 	return 0;
 }
+
+int32 AInSceneRecord::DrainQueue()
+{
+	int32 Encoded = 0;
+	FInRecordFrameRef Frame;
+	while (m_WrapOpenCv->m_ImageQueue.Pop(Frame))
+	{
+		SET_DWORD_STAT(STAT_InVideo_RecordQueueDepth, m_WrapOpenCv->m_ImageQueue.Num());
+		EncodeFrame(Frame);
+		++Encoded;
+	}
+	return Encoded;
+}
+
+void AInSceneRecord::EncodeFrame(FInRecordFrameRef& Frame)
+{
+	const double CaptureSeconds = Frame->CaptureSeconds;
+	// 直接在帧池的像素上转换，向量化内核按行分块在工作线程上并行
+	cv::Mat& Bgr = m_WrapOpenCv->m_BgrFrame;
+	Bgr.create(Frame->Height, Frame->Width, CV_8UC3);
+	InVideoPixelConvert::BGRAToBGRImage(reinterpret_cast<const uint8*>(Frame->Pixels.GetData()), Frame->Width * 4,
+		Bgr.data, (int32)Bgr.step, Frame->Width, Frame->Height);
+	// 转换完即归还帧
+	Frame.Reset();
+
+	const cv::Mat* Output = &m_WrapOpenCv->m_BgrFrame;
+	if (Output->size() != m_WrapOpenCv->m_OutputSize)
+	{
+		cv::resize(*Output, m_WrapOpenCv->m_ScaledFrame, m_WrapOpenCv->m_OutputSize, 0, 0, cv::INTER_LINEAR);
+		Output = &m_WrapOpenCv->m_ScaledFrame;
+	}
+	m_WrapOpenCv->m_VideoWriter.write(*Output);
+	RecordEncoded(CaptureSeconds);
+}
+
 void AInSceneRecord::Exit()
 {
 
 }
 void AInSceneRecord::Stop()
 {
-
-}
\ No newline at end of file
+	// FRunnableThread::Kill 先调用这里，唤醒等待中的编码线程和 BlockCapture 下等待的游戏线程
+	m_Stopping = true;
+	if (nullptr != m_WrapOpenCv)
+	{
+		m_WrapOpenCv->m_ImageQueue.Wake();
+	}
+}
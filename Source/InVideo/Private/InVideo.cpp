@@ -4,16 +4,33 @@
 #include "Core.h"
 #include "Modules/ModuleManager.h"
 #include "Interfaces/IPluginManager.h"
+#include "InVideoStats.h"
+#include "InVideoWorkerPool.h"
+#include "InVideoSurface.h"
+#include "InVideoUploadScheduler.h"
 
 
 
 #define LOCTEXT_NAMESPACE "FInVideoModule"
 
+DEFINE_STAT(STAT_InVideo_Seek);
+DEFINE_STAT(STAT_InVideo_LoopCount);
+DEFINE_STAT(STAT_InVideo_LoopHitchMs);
+DEFINE_STAT(STAT_InVideo_WorkerTick);
+DEFINE_STAT(STAT_InVideo_DecodeScale);
+DEFINE_STAT(STAT_InVideo_UploadFlush);
+DEFINE_STAT(STAT_InVideo_UploadsPerFrame);
+DEFINE_STAT(STAT_InVideo_SupersededUploads);
+DEFINE_STAT(STAT_InVideo_RecordQueueDepth);
+DEFINE_STAT(STAT_InVideo_RecordDropped);
+DEFINE_STAT(STAT_InVideo_RecordEncodeLagMs);
+
 void FInVideoModule::StartupModule()
 {
 	UE_LOG(LogTemp, Log, TEXT("FInVideoModule StartupModule"));
 
 	const FString PluginDir = IPluginManager::Get().FindPlugin(TEXT("InVideo"))->GetBaseDir();
+	FInVideoUploadScheduler::Startup();
 	const FString OpenCvBinPath = PluginDir / TEXT(PREPROCESSOR_TO_STRING(OPENCV_PLATFORM_PATH));
 	const FString DLLPath = OpenCvBinPath / TEXT(PREPROCESSOR_TO_STRING(OPENCV_DLL_NAME));
 	const FString DLLFFMPEGPath = OpenCvBinPath / TEXT(PREPROCESSOR_TO_STRING(OPENCV_DLL_FFMPEG));
@@ -33,6 +50,10 @@ void FInVideoModule::StartupModule()
 
 void FInVideoModule::ShutdownModule()
 {
+	// 先停工作线程，再卸载 OpenCV
+	FInVideoWorkerPool::Shutdown();
+	FInVideoTexturePool::Shutdown();
+	FInVideoUploadScheduler::Shutdown();
 	if (OpenCvDllHandle)
 	{
 		FPlatformProcess::FreeDllHandle(OpenCvDllHandle);
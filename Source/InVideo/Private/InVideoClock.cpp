@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoClock.h"
+#include "Misc/ScopeLock.h"
+
+const float FInVideoClock::JitterBucketBoundsMs[FInVideoClock::NumJitterBuckets - 1] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 33.0f };
+
+namespace
+{
+	// 显示时刻与当前时间相差超过该值时认为 PTS 不可信，直接以当前时间为基准
+	constexpr double MaxScheduleOffsetSeconds = 2.0;
+	constexpr double DriftSmoothing = 1.0 / 64.0;
+}
+
+void FInVideoClock::Reset()
+{
+	m_bHasBase = false;
+	m_LastIndex = INDEX_NONE;
+	m_Rate = 1.0;
+	m_Direction = 1;
+
+	FScopeLock Lock(&m_Mutex);
+	FMemory::Memzero(m_JitterHistogram);
+	m_PresentedFrames = 0;
+	m_DroppedFrames = 0;
+	m_RepeatedFrames = 0;
+	m_TotalAbsJitterMs = 0.0;
+	m_MaxJitterMs = 0.0;
+	m_DriftMs = 0.0;
+	m_RunSeconds = 0.0;
+	m_RunStartSeconds = -1.0;
+}
+
+void FInVideoClock::SetRate(double Rate, bool bReverse)
+{
+	const int32 Direction = bReverse ? -1 : 1;
+	if (Direction != m_Direction)
+	{
+		// 方向切换后帧号必然不连续，下一帧重新建立基准
+		m_Direction = Direction;
+		m_bHasBase = false;
+	}
+	if (Rate != m_Rate)
+	{
+		if (m_bHasBase)
+		{
+			m_BaseSeconds = m_LastDueSeconds;
+			m_BasePtsMs = m_LastPtsMs;
+		}
+		m_Rate = Rate;
+	}
+}
+
+void FInVideoClock::Pause(double NowSeconds)
+{
+	m_bHasBase = false;
+	FScopeLock Lock(&m_Mutex);
+	if (m_RunStartSeconds >= 0.0)
+	{
+		m_RunSeconds += NowSeconds - m_RunStartSeconds;
+		m_RunStartSeconds = -1.0;
+	}
+}
+
+void FInVideoClock::Resume()
+{
+	m_bHasBase = false;
+	m_LastIndex = INDEX_NONE;
+}
+
+double FInVideoClock::Schedule(int32 FrameIndex, double PtsMs, double FrameDurationMs, double NowSeconds)
+{
+	// 沿播放方向前进的帧都按 PTS 排期，解码端节流跳帧时时间轴不变；Seek 由调用方 Resume 重建基准
+	const bool bContinuous = m_bHasBase && m_LastIndex != INDEX_NONE && (FrameIndex - m_LastIndex) * m_Direction > 0;
+	if (!bContinuous)
+	{
+		// 紧接上一帧之后显示（无缝循环的回绕点不会多停一帧），但不早于当前时间
+		const double NextSlot = m_LastIndex != INDEX_NONE ? m_LastDueSeconds + GetFrameSeconds(FrameDurationMs) : NowSeconds;
+		m_BaseSeconds = FMath::Max(NowSeconds, NextSlot);
+		m_BasePtsMs = PtsMs;
+		m_bHasBase = true;
+	}
+
+	double DueSeconds = m_BaseSeconds + m_Direction * (PtsMs - m_BasePtsMs) / (1000.0 * m_Rate);
+	if (FMath::Abs(DueSeconds - NowSeconds) > MaxScheduleOffsetSeconds)
+	{
+		m_BaseSeconds = NowSeconds;
+		m_BasePtsMs = PtsMs;
+		DueSeconds = NowSeconds;
+	}
+
+	m_LastIndex = FrameIndex;
+	m_LastPtsMs = PtsMs;
+	m_LastDueSeconds = DueSeconds;
+	return DueSeconds;
+}
+
+double FInVideoClock::GetFrameSeconds(double FrameDurationMs) const
+{
+	return FrameDurationMs / (1000.0 * m_Rate);
+}
+
+void FInVideoClock::OnPresented(double DueSeconds, double NowSeconds, double FrameSeconds)
+{
+	const double ErrorMs = (NowSeconds - DueSeconds) * 1000.0;
+	const double AbsErrorMs = FMath::Abs(ErrorMs);
+	int32 Bucket = 0;
+	while (Bucket < NumJitterBuckets - 1 && AbsErrorMs >= JitterBucketBoundsMs[Bucket])
+	{
+		++Bucket;
+	}
+
+	FScopeLock Lock(&m_Mutex);
+	if (m_RunStartSeconds < 0.0)
+	{
+		m_RunStartSeconds = NowSeconds;
+	}
+	++m_JitterHistogram[Bucket];
+	++m_PresentedFrames;
+	if (FrameSeconds > 0.0 && ErrorMs > FrameSeconds * 1000.0)
+	{
+		// 上一帧因本帧迟到而多停留的帧数
+		m_RepeatedFrames += FMath::FloorToInt(ErrorMs / (FrameSeconds * 1000.0));
+	}
+	m_TotalAbsJitterMs += AbsErrorMs;
+	m_MaxJitterMs = FMath::Max(m_MaxJitterMs, AbsErrorMs);
+	m_DriftMs += (ErrorMs - m_DriftMs) * DriftSmoothing;
+}
+
+void FInVideoClock::OnDropped()
+{
+	FScopeLock Lock(&m_Mutex);
+	++m_DroppedFrames;
+}
+
+void FInVideoClock::FillStats(FInVideoPlayerStats& OutStats) const
+{
+	FScopeLock Lock(&m_Mutex);
+	OutStats.PresentJitterHistogram.SetNumUninitialized(NumJitterBuckets);
+	for (int32 i = 0; i < NumJitterBuckets; ++i)
+	{
+		OutStats.PresentJitterHistogram[i] = m_JitterHistogram[i];
+	}
+	OutStats.PresentedFrames = m_PresentedFrames;
+	OutStats.LateDroppedFrames = m_DroppedFrames;
+	OutStats.RepeatedFrames = m_RepeatedFrames;
+	OutStats.MeanAbsJitterMs = m_PresentedFrames > 0 ? m_TotalAbsJitterMs / m_PresentedFrames : 0.0;
+	OutStats.MaxJitterMs = m_MaxJitterMs;
+	OutStats.ClockDriftMs = m_DriftMs;
+	const double RunSeconds = m_RunSeconds + (m_RunStartSeconds >= 0.0 ? FPlatformTime::Seconds() - m_RunStartSeconds : 0.0);
+	// 第一帧显示时开始计时，帧数减一才是经过的帧间隔数
+	OutStats.MeasuredFps = RunSeconds > 0.0 && m_PresentedFrames > 1 ? (m_PresentedFrames - 1) / RunSeconds : 0.0;
+}
+
+void FInVideoClock::LogSummary(const FString& VideoURL) const
+{
+	FInVideoPlayerStats Stats;
+	FillStats(Stats);
+	if (Stats.PresentedFrames == 0)
+	{
+		return;
+	}
+	FString Histogram;
+	for (int32 i = 0; i < NumJitterBuckets; ++i)
+	{
+		Histogram += i < NumJitterBuckets - 1
+			? FString::Printf(TEXT(" <%.0fms:%d"), JitterBucketBoundsMs[i], Stats.PresentJitterHistogram[i])
+			: FString::Printf(TEXT(" >=%.0fms:%d"), JitterBucketBoundsMs[i - 1], Stats.PresentJitterHistogram[i]);
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoClock %s 显示 %d 帧 %.3f fps 丢弃 %d 重复 %d 平均抖动 %.2f ms 最大 %.2f ms 漂移 %.2f ms 直方图:%s"),
+		*VideoURL, Stats.PresentedFrames, Stats.MeasuredFps, Stats.LateDroppedFrames, Stats.RepeatedFrames,
+		Stats.MeanAbsJitterMs, Stats.MaxJitterMs, Stats.ClockDriftMs, *Histogram);
+}
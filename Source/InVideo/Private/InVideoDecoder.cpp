@@ -0,0 +1,1291 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoDecoder.h"
+#include "InVideoWorkerPool.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/imgproc.hpp>
+#include "PostOpenCVHeaders.h"
+
+namespace
+{
+	// 直播模式每次最多连续丢弃的积压帧数，防止后端一直返回缓存帧时饿死显示
+	constexpr int32 MaxLiveDrainFrames = 30;
+	// 暂停或队列满时的兜底轮询间隔，正常情况下由 Wake 提前唤醒
+	constexpr double IdleTickSeconds = 0.05;
+	// 读取失败后的重试间隔，避免在坏流上空转
+	constexpr double FailedReadRetrySeconds = 0.005;
+	// 关闭自动重连时，直播连续读取失败这么多次即结束并通知失败
+	constexpr int32 MaxLiveReadFailures = 3;
+	// 等待后台打开或解码时的轮询间隔，轮询本身不阻塞工作线程
+	constexpr double IoPollSeconds = 0.002;
+
+	// 每执行一次 InVideo.SimulateStreamDrop 加一，各直播解码器在下一次读取时按断流处理
+	TAtomic<int32> GSimulatedDropGeneration(0);
+
+	void SimulateStreamDrop()
+	{
+		++GSimulatedDropGeneration;
+		UE_LOG(LogTemp, Log, TEXT("InVideo.SimulateStreamDrop: 所有直播流将在下一次读取时断开重连"));
+	}
+
+	FAutoConsoleCommand SimulateStreamDropCommand(
+		TEXT("InVideo.SimulateStreamDrop"),
+		TEXT("模拟所有直播网络流断流，用于验证自动重连"),
+		FConsoleCommandDelegate::CreateStatic(&SimulateStreamDrop));
+
+	// 连续存放的 YUV420 (I420/NV12) 按平面分别用面积插值缩小，Dst 已按输出尺寸分配（偶数尺寸）
+	// 源的色度平面与 InVideoPlanes::GetPlaneLayout 一致，奇数尺寸向上取整
+	void ScaleYUV420(const cv::Mat& Src, int32 SrcWidth, int32 SrcHeight, EInVideoPlaneLayout Layout, cv::Mat& Dst, int32 DstWidth, int32 DstHeight)
+	{
+		cv::Mat DstY(DstHeight, DstWidth, CV_8UC1, Dst.data);
+		cv::resize(cv::Mat(SrcHeight, SrcWidth, CV_8UC1, Src.data), DstY, DstY.size(), 0, 0, cv::INTER_AREA);
+
+		uint8* SrcChroma = Src.data + (size_t)SrcWidth * SrcHeight;
+		uint8* DstChroma = Dst.data + (size_t)DstWidth * DstHeight;
+		const cv::Size SrcChromaSize((SrcWidth + 1) / 2, (SrcHeight + 1) / 2);
+		const cv::Size DstChromaSize(DstWidth / 2, DstHeight / 2);
+		if (Layout == EInVideoPlaneLayout::NV12)
+		{
+			// UV 交错平面按双通道图像缩放
+			cv::Mat DstUV(DstChromaSize, CV_8UC2, DstChroma);
+			cv::resize(cv::Mat(SrcChromaSize, CV_8UC2, SrcChroma), DstUV, DstChromaSize, 0, 0, cv::INTER_AREA);
+			return;
+		}
+		const size_t SrcChromaBytes = (size_t)SrcChromaSize.area();
+		const size_t DstChromaBytes = (size_t)DstChromaSize.area();
+		cv::Mat DstU(DstChromaSize, CV_8UC1, DstChroma);
+		cv::Mat DstV(DstChromaSize, CV_8UC1, DstChroma + DstChromaBytes);
+		cv::resize(cv::Mat(SrcChromaSize, CV_8UC1, SrcChroma), DstU, DstChromaSize, 0, 0, cv::INTER_AREA);
+		cv::resize(cv::Mat(SrcChromaSize, CV_8UC1, SrcChroma + SrcChromaBytes), DstV, DstChromaSize, 0, 0, cv::INTER_AREA);
+	}
+}
+
+FInVideoDecoder::FInVideoDecoder(TInVideoRing<FInVideoFrame>& Ring)
+	: m_Ring(Ring)
+{
+}
+
+FInVideoDecoder::~FInVideoDecoder()
+{
+	StopDecode();
+}
+
+void FInVideoDecoder::Start(const FString& VideoURL, const bool RealMode)
+{
+	StopDecode();
+	m_VideoURL = VideoURL;
+	m_RealMode = RealMode;
+	m_Stopping = false;
+	m_FrameDurationMs = 0.0;
+	m_SimulatedDropGeneration = GSimulatedDropGeneration;
+	m_State = EDecodeState::Opening;
+	m_bStreamInitialized = false;
+	m_bFramePending = false;
+	m_bIoPending = false;
+	m_bPrefetchUnavailable = false;
+	m_LiveReadFailures = 0;
+	// 直播和网络流的 open/grab 会阻塞到超时，放在有上限的 I/O 线程组上，不占用解码/显示线程
+	m_bBlockingIO = m_bLive || IsNetworkURL(VideoURL);
+	FInVideoWorkerPool::FTickFunction TickFunction = [this](double NowSeconds) { return Tick(NowSeconds); };
+	m_Task = m_bBlockingIO
+		? FInVideoWorkerPool::Get().RegisterBlocking(TEXT("Decode ") + VideoURL, MoveTemp(TickFunction))
+		: FInVideoWorkerPool::Get().Register(TEXT("Decode ") + VideoURL, MoveTemp(TickFunction));
+}
+
+void FInVideoDecoder::StopDecode()
+{
+	m_Stopping = true;
+	m_Ring.Wake();
+	if (m_Task.IsValid())
+	{
+		// 等待正在执行的 Tick 结束后再释放资源
+		FInVideoWorkerPool::Get().Unregister(m_Task);
+		m_Task.Reset();
+	}
+	// Tick 已停止，等待后台的打开、预取和备用流定位结束后再释放
+	if (m_OpenFuture.IsValid())
+	{
+		m_OpenFuture.Wait();
+		m_OpenFuture = TFuture<bool>();
+	}
+	if (m_PrefetchFuture.IsValid())
+	{
+		m_PrefetchFuture.Wait();
+		m_PrefetchFuture = TFuture<bool>();
+	}
+	m_bDiscardPrefetch = false;
+	ResetReverseCache();
+	if (m_LoopStreamFuture.IsValid())
+	{
+		m_LoopStreamFuture.Wait();
+		m_LoopStreamFuture = TFuture<bool>();
+	}
+	m_bDiscardLoopStream = false;
+	ResetLoopHead();
+	if (m_IndexFuture.IsValid())
+	{
+		m_IndexFuture.Wait();
+		m_IndexFuture = TFuture<TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe>>();
+	}
+	if (m_PrefetchStream.isOpened())
+	{
+		m_PrefetchStream.release();
+	}
+	if (m_Stream.isOpened())
+	{
+		m_Stream.release();
+	}
+}
+
+void FInVideoDecoder::Seek(int32 FrameIndex)
+{
+	m_PendingSeek = FMath::Max(0, FrameIndex);
+	Wake();
+}
+
+void FInVideoDecoder::SetReverse(bool bReverse)
+{
+	m_bReverse = bReverse;
+	Wake();
+}
+
+void FInVideoDecoder::SetPaused(bool bPaused)
+{
+	m_bPaused = bPaused;
+	Wake();
+}
+
+void FInVideoDecoder::SetNativeOutput(bool bNative)
+{
+	m_bNativeOutput = bNative;
+}
+
+void FInVideoDecoder::SetReverseCacheBudget(int64 Bytes)
+{
+	m_ReverseCacheBytes = FMath::Max<int64>(Bytes, 1);
+}
+
+void FInVideoDecoder::SetGaplessLoop(bool bEnable, int32 HeadFrames)
+{
+	m_bGaplessLoop = bEnable;
+	m_LoopHeadFrames = FMath::Max(1, HeadFrames);
+}
+
+void FInVideoDecoder::SetLiveMode(bool bLive, int32 OpenTimeoutMs, int32 ReadTimeoutMs)
+{
+	m_bLive = bLive;
+	m_OpenTimeoutMs = FMath::Max(1, OpenTimeoutMs);
+	m_ReadTimeoutMs = FMath::Max(1, ReadTimeoutMs);
+}
+
+void FInVideoDecoder::SetReconnect(bool bEnable, float InitialDelaySeconds, float MaxDelaySeconds, int32 MaxAttempts)
+{
+	m_bAutoReconnect = bEnable;
+	m_ReconnectInitialDelay = FMath::Max(0.01f, InitialDelaySeconds);
+	m_ReconnectMaxDelay = FMath::Max(m_ReconnectInitialDelay, MaxDelaySeconds);
+	m_ReconnectMaxAttempts = FMath::Max(0, MaxAttempts);
+}
+
+void FInVideoDecoder::SetOutputSize(FIntPoint Size)
+{
+	FScopeLock Lock(&m_StatsMutex);
+	m_RequestedOutputSize = Size.X > 0 && Size.Y > 0 ? Size : FIntPoint::ZeroValue;
+}
+
+void FInVideoDecoder::SetThrottle(EInVideoDecodeThrottle Throttle, float MaxFps)
+{
+	m_ThrottleIntervalMs = FMath::Max(1, FMath::RoundToInt(1000.0f / FMath::Max(0.1f, MaxFps)));
+	m_Throttle = (uint8)Throttle;
+	Wake();
+}
+
+double FInVideoDecoder::Tick(double NowSeconds)
+{
+	if (m_Stopping)
+	{
+		return -1.0;
+	}
+	switch (m_State)
+	{
+	case EDecodeState::Opening:
+		return TickOpen(NowSeconds);
+	case EDecodeState::Reconnecting:
+		return TickReconnect(NowSeconds);
+	case EDecodeState::Finished:
+		return -1.0;
+	default:
+		break;
+	}
+
+	// 暂停时不再解码，避免 DropOldest 策略下空转丢帧；恢复时会被唤醒
+	// 不可见挂起的文件源同样处理，时间轴停在挂起时的位置
+	const EInVideoDecodeThrottle Throttle = (EInVideoDecodeThrottle)m_Throttle.Load();
+	if (m_bPaused || (Throttle == EInVideoDecodeThrottle::Suspend && !IsLiveSource()))
+	{
+		return NowSeconds + IdleTickSeconds;
+	}
+
+	UpdateKeyframeIndex();
+	PollLoopStream();
+	ApplyPendingSeek();
+	UpdateOutputScale();
+
+	// 上一帧还没放进队列（队列满），等显示端取走一帧后被唤醒
+	if (m_bFramePending && !PushPendingFrame())
+	{
+		return NowSeconds + IdleTickSeconds;
+	}
+
+	// 不可见的直播源在两次输出之间只 grab，网络会话和接收缓冲保持最新
+	if (Throttle != EInVideoDecodeThrottle::None && IsLiveSource()
+		&& (Throttle == EInVideoDecodeThrottle::Suspend || NowSeconds < m_NextThrottledFrameSeconds))
+	{
+		return KeepLiveSessionAlive(NowSeconds);
+	}
+
+	if (false == DecodeStep() || false == ClassifyFrame())
+	{
+		if (m_bIoPending)
+		{
+			m_bIoPending = false;
+			return NowSeconds + IoPollSeconds;
+		}
+		if (m_State == EDecodeState::Reconnecting)
+		{
+			return m_NextReconnectSeconds;
+		}
+		return m_State == EDecodeState::Finished ? -1.0 : NowSeconds + FailedReadRetrySeconds;
+	}
+	CaptureLoopHead();
+	ScaleToOutput();
+	if (Throttle != EInVideoDecodeThrottle::None)
+	{
+		m_NextThrottledFrameSeconds = NowSeconds + m_ThrottleIntervalMs / 1000.0;
+		SkipThrottledFrames(Throttle);
+	}
+
+	// 队列满时按策略覆盖最旧帧，或保留到下一次 Tick 再放
+	m_bFramePending = true;
+	PushPendingFrame();
+	return NowSeconds;
+}
+
+double FInVideoDecoder::TickOpen(double NowSeconds)
+{
+	bool bOpened = false;
+	if (m_bBlockingIO)
+	{
+		UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 打开视频流 进入"));
+		bOpened = OpenStream();
+	}
+	else
+	{
+		// 文件源在后台打开，慢速磁盘或网络共享上也不占用工作线程
+		if (!m_OpenFuture.IsValid())
+		{
+			UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 打开视频流 进入"));
+			m_OpenFuture = Async(EAsyncExecution::ThreadPool, [this]() { return OpenStream(); });
+		}
+		if (!m_OpenFuture.IsReady())
+		{
+			return NowSeconds + IoPollSeconds;
+		}
+		bOpened = m_OpenFuture.Get();
+		m_OpenFuture = TFuture<bool>();
+	}
+	if (false == bOpened)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FInVideoDecoder 打开视频失败 url=%s"), *m_VideoURL);
+		// 网络流首次打开失败也按断流处理，摄像头稍后上线时自动恢复
+		if (m_bAutoReconnect && IsNetworkURL(m_VideoURL))
+		{
+			BeginReconnect(NowSeconds);
+			return m_State == EDecodeState::Reconnecting ? m_NextReconnectSeconds : -1.0;
+		}
+		Fail();
+		m_State = EDecodeState::Finished;
+		return -1.0;
+	}
+	if (!InitStream())
+	{
+		Fail();
+		m_State = EDecodeState::Finished;
+		return -1.0;
+	}
+	m_State = EDecodeState::Decoding;
+	return NowSeconds;
+}
+
+bool FInVideoDecoder::InitStream()
+{
+	m_TotalFrames = m_Stream.get(cv::CAP_PROP_FRAME_COUNT);
+	if (m_TotalFrames <= 0 && (m_bLive || IsNetworkURL(m_VideoURL)))
+	{
+		// 直播流没有总帧数，只能按实时模式顺序读取
+		UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 网络流无总帧数, 按实时模式播放 url=%s"), *m_VideoURL);
+		m_RealMode = true;
+	}
+	else if (m_TotalFrames <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FInVideoDecoder 获取视频总帧数失败或为0 url=%s"), *m_VideoURL);
+		m_Stream.release();
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 打开视频成功, 总帧数: %d"), m_TotalFrames);
+	ConfigureNativeOutput();
+
+	// 文件源在后台建立关键帧索引
+	m_KeyframeIndex.Reset();
+	if (!IsNetworkURL(m_VideoURL))
+	{
+		m_IndexFuture = Async(EAsyncExecution::ThreadPool, [VideoURL = m_VideoURL]()
+			{
+				return FInVideoKeyframeIndex::LoadOrBuild(VideoURL);
+			});
+	}
+
+	// 一段的默认长度按常见的 2 秒 GOP 估计
+	const double StreamFps = m_Stream.get(cv::CAP_PROP_FPS);
+	m_ReverseGopFrames = StreamFps > 0 ? FMath::Max(1, FMath::RoundToInt(StreamFps * 2.0)) : 50;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_FrameDurationMs = StreamFps > 0 ? 1000.0 / StreamFps : 40.0;
+	}
+
+	// 初始化帧索引：正向为下一个要读的帧，反向为上一个交出的帧（首次交出最后一帧）
+	m_bDecodingReverse = m_bReverse;
+	m_CurrentFrameIndex = m_bDecodingReverse ? m_TotalFrames : 0;
+	if (!m_bDecodingReverse)
+	{
+		m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
+	}
+	m_bStreamInitialized = true;
+	return true;
+}
+
+bool FInVideoDecoder::PushPendingFrame()
+{
+	if (!m_Ring.TryPush(m_Frame))
+	{
+		return false;
+	}
+	m_bFramePending = false;
+	if (OnFramePushed)
+	{
+		OnFramePushed();
+	}
+	return true;
+}
+
+void FInVideoDecoder::Wake()
+{
+	FInVideoWorkerPool::Get().Wake(m_Task);
+}
+
+bool FInVideoDecoder::OpenStream()
+{
+	if (!m_bLive && !IsNetworkURL(m_VideoURL))
+	{
+		return m_Stream.open(TCHAR_TO_UTF8(*m_VideoURL));
+	}
+
+	// 超时参数必须在打开时传入，断流时 read 超时返回失败而不是无限阻塞，重连依赖这一点
+	const std::vector<int> Params = {
+		cv::CAP_PROP_OPEN_TIMEOUT_MSEC, m_OpenTimeoutMs,
+		cv::CAP_PROP_READ_TIMEOUT_MSEC, m_ReadTimeoutMs };
+	if (!m_Stream.open(TCHAR_TO_UTF8(*m_VideoURL), cv::CAP_FFMPEG, Params))
+	{
+		return false;
+	}
+	if (m_bLive && !m_Stream.set(cv::CAP_PROP_BUFFERSIZE, 1))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("FInVideoDecoder 后端不支持 CAP_PROP_BUFFERSIZE, 依靠 grab 丢弃积压帧"));
+	}
+	// RTSP 等源由 RTCP 提供流开始的绝对时间，用于估算端到端延迟
+	m_StreamOpenTimeUs = m_Stream.get(cv::CAP_PROP_STREAM_OPEN_TIME_USEC);
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 网络流打开 url=%s 流开始时间 %s"), *m_VideoURL,
+		m_StreamOpenTimeUs > 0.0 ? *FDateTime::FromUnixTimestamp((int64)(m_StreamOpenTimeUs / 1000000.0)).ToString() : TEXT("未知"));
+	return true;
+}
+
+bool FInVideoDecoder::DecodeStep()
+{
+	if (IsLiveSource())
+	{
+		const bool bFrameRead = !ConsumeSimulatedDrop() && (m_bLive ? ReadLive() : ReadRealtime());
+		if (!bFrameRead)
+		{
+			HandleLiveReadFailure(FPlatformTime::Seconds());
+		}
+		else
+		{
+			m_LiveReadFailures = 0;
+		}
+		return bFrameRead;
+	}
+
+	// --- 非实时模式 ---
+	if (false == m_RealMode)
+	{
+		// 播放方向切换时丢弃反向缓存，并换算帧索引的含义
+		const bool bReverse = m_bReverse;
+		if (bReverse != m_bDecodingReverse)
+		{
+			m_bDecodingReverse = bReverse;
+			m_LoopHeadCursor = INDEX_NONE;
+			ResetReverseCache();
+			if (bReverse)
+			{
+				m_CurrentFrameIndex = FMath::Max(0, m_CurrentFrameIndex - 1);
+			}
+			else
+			{
+				m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % FMath::Max(1, m_TotalFrames);
+				SeekToFrame(m_Stream, m_CurrentFrameIndex);
+			}
+		}
+
+		const bool bFrameReadSuccess = bReverse ? ReadReverse() : ReadForward();
+		if (false == bFrameReadSuccess && !m_bIoPending)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("非实时模式: 在帧 %d 处读取失败 (非循环点)."), m_CurrentFrameIndex);
+		}
+		return bFrameReadSuccess;
+	}
+
+	// --- 实时模式 ---
+	if (ReadRealtime())
+	{
+		return true;
+	}
+
+	// 实时模式读取失败，处理循环和到达末尾通知
+	if (!m_bReverse)
+	{
+		if (OnReachedEnd)
+		{
+			OnReachedEnd();
+		}
+		UE_LOG(LogTemp, Verbose, TEXT("FInVideoDecoder 到达末尾 (实时模式读取失败/结束)"));
+		m_CurrentFrameIndex = 0;
+	}
+	else
+	{
+		m_CurrentFrameIndex = m_TotalFrames - 1;
+	}
+	SeekToFrame(m_Stream, m_CurrentFrameIndex);
+	return false;
+}
+
+bool FInVideoDecoder::ReadRealtime()
+{
+	if (false == m_Stream.read(GetReadTarget()))
+	{
+		return false;
+	}
+	// get 返回的是下一帧的索引
+	m_CurrentFrameIndex = m_Stream.get(cv::CAP_PROP_POS_FRAMES);
+	m_Frame.FrameIndex = m_CurrentFrameIndex - 1;
+	m_Frame.PtsMs = ReadPts(m_Stream, m_Frame.FrameIndex);
+	return true;
+}
+
+double FInVideoDecoder::KeepLiveSessionAlive(double NowSeconds)
+{
+	// grab 只解码不做颜色转换和分发；没有新数据时阻塞到下一帧到达，不会空转。直播源在 I/O 线程上，阻塞不影响解码/显示线程
+	if (ConsumeSimulatedDrop() || !m_Stream.grab())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 节流期间直播读取失败或超时 url=%s"), *m_VideoURL);
+		HandleLiveReadFailure(NowSeconds);
+		if (m_State == EDecodeState::Reconnecting)
+		{
+			return m_NextReconnectSeconds;
+		}
+		return m_State == EDecodeState::Finished ? -1.0 : NowSeconds + FailedReadRetrySeconds;
+	}
+	++m_CurrentFrameIndex;
+	m_LiveReadFailures = 0;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		++m_ThrottledFrames;
+	}
+	return FPlatformTime::Seconds();
+}
+
+void FInVideoDecoder::SkipThrottledFrames(EInVideoDecodeThrottle Throttle)
+{
+	// 只处理正向顺序解码的文件源；时间轴照常推进，显示端按 PTS 排期，跳帧不会加快播放
+	if (IsLiveSource() || m_bDecodingReverse || m_LoopHeadCursor != INDEX_NONE || m_TotalFrames <= 0)
+	{
+		return;
+	}
+	int32 Skipped = 0;
+	if (Throttle == EInVideoDecodeThrottle::KeyframesOnly && m_KeyframeIndex.IsValid())
+	{
+		// 直接定位到下一个关键帧，中间的帧不解码；最后一个 GOP 照常顺序读到末尾，循环逻辑不变
+		const int32 NextKeyframe = m_KeyframeIndex->GetNextKeyframe(m_Frame.FrameIndex);
+		if (NextKeyframe > m_CurrentFrameIndex && NextKeyframe < m_TotalFrames)
+		{
+			m_Stream.set(cv::CAP_PROP_POS_FRAMES, NextKeyframe);
+			Skipped = NextKeyframe - m_CurrentFrameIndex;
+			m_CurrentFrameIndex = NextKeyframe;
+		}
+	}
+	else
+	{
+		// 跳过的帧只 grab，省掉颜色转换、分发和上传；留下最后一帧给 ReadForward 处理文件末尾
+		const double FrameMs = m_FrameDurationMs > 0.0 ? m_FrameDurationMs : 40.0;
+		const int32 SkipFrames = FMath::Max(0, FMath::RoundToInt(m_ThrottleIntervalMs / FrameMs) - 1);
+		while (Skipped < SkipFrames && m_CurrentFrameIndex < m_TotalFrames - 1 && false == m_Stopping)
+		{
+			if (!m_Stream.grab())
+			{
+				break;
+			}
+			++m_CurrentFrameIndex;
+			++Skipped;
+		}
+	}
+	if (Skipped > 0)
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_ThrottledFrames += Skipped;
+	}
+}
+
+bool FInVideoDecoder::IsLiveSource() const
+{
+	return m_bLive || (m_TotalFrames <= 0 && IsNetworkURL(m_VideoURL));
+}
+
+void FInVideoDecoder::HandleLiveReadFailure(double NowSeconds)
+{
+	if (m_bAutoReconnect)
+	{
+		BeginReconnect(NowSeconds);
+		return;
+	}
+	// 不重连时不在坏流上一直重试：连续失败几次后结束，由 OnFailed 通知控件
+	if (++m_LiveReadFailures < MaxLiveReadFailures)
+	{
+		return;
+	}
+	UE_LOG(LogTemp, Error, TEXT("FInVideoDecoder 直播连续 %d 次读取失败且未开启自动重连, 停止 url=%s"), m_LiveReadFailures, *m_VideoURL);
+	if (m_Stream.isOpened())
+	{
+		m_Stream.release();
+	}
+	m_bFramePending = false;
+	m_State = EDecodeState::Finished;
+	Fail();
+}
+
+void FInVideoDecoder::BeginReconnect(double NowSeconds)
+{
+	// 断流期间不再向队列写帧，显示端保留最后一帧画面
+	if (m_Stream.isOpened())
+	{
+		m_Stream.release();
+	}
+	m_bFramePending = false;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_bReconnecting = true;
+		m_ReconnectAttempt = 0;
+	}
+	ScheduleReconnect(NowSeconds);
+}
+
+void FInVideoDecoder::ScheduleReconnect(double NowSeconds)
+{
+	int32 Attempt = 0;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		Attempt = ++m_ReconnectAttempt;
+	}
+	if (m_ReconnectMaxAttempts > 0 && Attempt > m_ReconnectMaxAttempts)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FInVideoDecoder 重连 %d 次失败, 放弃 url=%s"), m_ReconnectMaxAttempts, *m_VideoURL);
+		{
+			FScopeLock Lock(&m_StatsMutex);
+			m_bReconnecting = false;
+		}
+		m_State = EDecodeState::Finished;
+		Fail();
+		return;
+	}
+
+	// 等待期间不占用工作线程，到期后由 TickReconnect 尝试打开
+	const double Delay = GetReconnectDelay(Attempt);
+	m_NextReconnectSeconds = NowSeconds + Delay;
+	m_State = EDecodeState::Reconnecting;
+	UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 断流, %.2f 秒后第 %d 次重连 url=%s"), Delay, Attempt, *m_VideoURL);
+	if (OnReconnecting)
+	{
+		OnReconnecting(Attempt, (float)Delay);
+	}
+}
+
+double FInVideoDecoder::TickReconnect(double NowSeconds)
+{
+	if (NowSeconds < m_NextReconnectSeconds)
+	{
+		return m_NextReconnectSeconds;
+	}
+	if (!OpenStream())
+	{
+		ScheduleReconnect(FPlatformTime::Seconds());
+		return m_State == EDecodeState::Reconnecting ? m_NextReconnectSeconds : -1.0;
+	}
+
+	// 首次打开就失败的流在这里完成初始化
+	if (!m_bStreamInitialized && !InitStream())
+	{
+		ScheduleReconnect(FPlatformTime::Seconds());
+		return m_State == EDecodeState::Reconnecting ? m_NextReconnectSeconds : -1.0;
+	}
+	ConfigureNativeOutput();
+
+	int32 Attempt = 0;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		Attempt = m_ReconnectAttempt;
+		m_bReconnecting = false;
+		m_ReconnectAttempt = 0;
+		++m_ReconnectCount;
+	}
+	m_State = EDecodeState::Decoding;
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 第 %d 次重连成功 url=%s"), Attempt, *m_VideoURL);
+	if (OnRecovered)
+	{
+		OnRecovered();
+	}
+	return FPlatformTime::Seconds();
+}
+
+double FInVideoDecoder::GetReconnectDelay(int32 Attempt) const
+{
+	// 指数退避，取上限后在 [50%, 100%] 之间随机，避免多路摄像头同时断开后同时重连
+	const double Backoff = FMath::Min<double>(m_ReconnectMaxDelay, m_ReconnectInitialDelay * FMath::Pow(2.0, (double)FMath::Min(Attempt - 1, 30)));
+	return Backoff * FMath::FRandRange(0.5, 1.0);
+}
+
+bool FInVideoDecoder::ConsumeSimulatedDrop()
+{
+	const int32 Generation = GSimulatedDropGeneration;
+	if (Generation == m_SimulatedDropGeneration)
+	{
+		return false;
+	}
+	m_SimulatedDropGeneration = Generation;
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 模拟断流 url=%s"), *m_VideoURL);
+	return true;
+}
+
+bool FInVideoDecoder::ReadLive()
+{
+	// grab 立即返回说明取到的是缓冲中的积压帧，继续 grab 直到需要等待网络数据，只 retrieve 最后一帧
+	const double FastGrabSeconds = FMath::Max(0.002, m_FrameDurationMs / 1000.0 * 0.5);
+	double GrabStart = FPlatformTime::Seconds();
+	if (!m_Stream.grab())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 直播读取失败或超时 url=%s"), *m_VideoURL);
+		return false;
+	}
+	int32 Drained = 0;
+	while (FPlatformTime::Seconds() - GrabStart < FastGrabSeconds && Drained < MaxLiveDrainFrames && false == m_Stopping)
+	{
+		GrabStart = FPlatformTime::Seconds();
+		if (!m_Stream.grab())
+		{
+			return false;
+		}
+		++Drained;
+	}
+	if (!m_Stream.retrieve(GetReadTarget()))
+	{
+		return false;
+	}
+
+	m_Frame.FrameIndex = m_CurrentFrameIndex++;
+	m_Frame.PtsMs = m_Stream.get(cv::CAP_PROP_POS_MSEC);
+	m_Frame.CaptureEpochMs = m_StreamOpenTimeUs > 0.0 ? m_StreamOpenTimeUs / 1000.0 + m_Frame.PtsMs : -1.0;
+	m_Frame.DecodedSeconds = FPlatformTime::Seconds();
+	if (Drained > 0)
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_LiveDrainedFrames += Drained;
+	}
+	return true;
+}
+
+bool FInVideoDecoder::ReadForward()
+{
+	// 回绕后先从内存交出片头，此时 m_Stream 已定位在片头之后
+	if (m_LoopHeadCursor != INDEX_NONE)
+	{
+		const FInVideoFrame& Head = m_LoopHead[m_LoopHeadCursor];
+		Head.Image.copyTo(GetReadTarget());
+		m_Frame.FrameIndex = Head.FrameIndex;
+		m_Frame.PtsMs = Head.PtsMs;
+		m_CurrentFrameIndex = ++m_LoopHeadCursor;
+		if (m_LoopHeadCursor >= m_LoopHead.Num())
+		{
+			m_LoopHeadCursor = INDEX_NONE;
+		}
+		return true;
+	}
+
+	bool bFrameReadSuccess = false;
+	if (m_Stream.read(GetReadTarget()))
+	{
+		bFrameReadSuccess = true;
+		m_Frame.FrameIndex = m_CurrentFrameIndex;
+		m_Frame.PtsMs = ReadPts(m_Stream, m_CurrentFrameIndex);
+		m_CurrentFrameIndex++;
+	}
+
+	// 检查是否到达末尾 (读取失败或索引超限)
+	if (!bFrameReadSuccess || m_CurrentFrameIndex >= m_TotalFrames)
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("非实时模式: 到达视频末尾 (读取 %s, Index %d >= %d)."),
+			bFrameReadSuccess ? TEXT("成功") : TEXT("失败"), m_CurrentFrameIndex, m_TotalFrames);
+
+		if (OnReachedEnd)
+		{
+			OnReachedEnd();
+		}
+
+		// 无缝循环：切换到已定位好的备用流，片头从内存交出
+		if (TryGaplessWrap())
+		{
+			return bFrameReadSuccess || ReadForward();
+		}
+
+		// 重置到开头实现循环播放
+		m_CurrentFrameIndex = 0;
+		SeekToFrame(m_Stream, m_CurrentFrameIndex);
+
+		// 最后一帧读取成功时先交给队列，下一次再从头读取
+		if (!bFrameReadSuccess && m_Stream.read(GetReadTarget()))
+		{
+			bFrameReadSuccess = true;
+			m_Frame.FrameIndex = m_CurrentFrameIndex;
+			m_Frame.PtsMs = ReadPts(m_Stream, m_CurrentFrameIndex);
+			m_CurrentFrameIndex++;
+		}
+	}
+	return bFrameReadSuccess;
+}
+
+bool FInVideoDecoder::ReadReverse()
+{
+	if (m_ReverseChunk.Remaining == 0 && !FillReverseChunk())
+	{
+		return false;
+	}
+
+	// 从缓存段末尾倒序交出，Mat 交换给读取目标，旧缓冲换回段内下次复用
+	FInVideoFrame& Cached = m_ReverseChunk.Frames[--m_ReverseChunk.Remaining];
+	cv::swap(GetReadTarget(), Cached.Image);
+	m_Frame.FrameIndex = Cached.FrameIndex;
+	m_Frame.PtsMs = Cached.PtsMs;
+	m_CurrentFrameIndex = m_Frame.FrameIndex;
+	return true;
+}
+
+bool FInVideoDecoder::FillReverseChunk()
+{
+	// 目标区间为上一个交出帧之前的一段，到开头时回绕到末尾
+	const int32 End = m_CurrentFrameIndex > 0 ? m_CurrentFrameIndex : m_TotalFrames;
+	const int32 Start = GetReverseChunkStart(End);
+
+	if (m_PrefetchFuture.IsValid())
+	{
+		// 后台还在解码时不等待，下一次 Tick 再取
+		if (!m_PrefetchFuture.IsReady())
+		{
+			m_bIoPending = true;
+			return false;
+		}
+		m_bPrefetchUnavailable = !m_PrefetchFuture.Get();
+		m_PrefetchFuture = TFuture<bool>();
+		if (!m_bDiscardPrefetch && m_PrefetchChunk.Start == Start && m_PrefetchChunk.End == End && m_PrefetchChunk.Remaining > 0)
+		{
+			Swap(m_ReverseChunk, m_PrefetchChunk);
+		}
+		m_bDiscardPrefetch = false;
+	}
+
+	// 预取未命中（首次、Seek 之后或方向切换）：当前段也交给后台解码，完成后由之后的 Tick 取用
+	if (m_ReverseChunk.Remaining == 0)
+	{
+		if (StartPrefetch(Start, End))
+		{
+			m_bIoPending = true;
+			return false;
+		}
+		// 预取流打不开时退回同步解码
+		if (!DecodeChunk(m_Stream, Start, End, m_ReverseChunk))
+		{
+			return false;
+		}
+	}
+
+	// 在后台预取再往前的一段，显示当前段期间完成解码
+	const int32 PrevEnd = Start > 0 ? Start : m_TotalFrames;
+	StartPrefetch(GetReverseChunkStart(PrevEnd), PrevEnd);
+	return true;
+}
+
+bool FInVideoDecoder::DecodeChunk(cv::VideoCapture& Stream, int32 Start, int32 End, FReverseChunk& Chunk)
+{
+	// 每段只 Seek 一次，之后顺序解码，避免逐帧 Seek 导致每帧都从关键帧重新解码
+	Chunk.Start = Start;
+	Chunk.End = End;
+	Chunk.Remaining = 0;
+	// 扩容会按字节搬移 cv::Mat，先清空再分配；缩小时保留内存
+	if (Chunk.Frames.Max() < End - Start)
+	{
+		Chunk.Frames.Empty(End - Start);
+	}
+	Chunk.Frames.SetNum(End - Start, false);
+	SeekToFrame(Stream, Start);
+	for (int32 Index = Start; Index < End && false == m_Stopping; ++Index)
+	{
+		FInVideoFrame& Frame = Chunk.Frames[Chunk.Remaining];
+		if (!Stream.read(Frame.Image))
+		{
+			break;
+		}
+		Frame.FrameIndex = Index;
+		Frame.PtsMs = ReadPts(Stream, Index);
+		++Chunk.Remaining;
+	}
+	return Chunk.Remaining > 0;
+}
+
+bool FInVideoDecoder::StartPrefetch(int32 Start, int32 End)
+{
+	if (m_bPrefetchUnavailable)
+	{
+		return false;
+	}
+	// 预取流也在后台打开
+	m_PrefetchFuture = Async(EAsyncExecution::ThreadPool, [this, Start, End, bRawYUV = m_bRawYUV]()
+		{
+			if (!m_PrefetchStream.isOpened())
+			{
+				if (!m_PrefetchStream.open(TCHAR_TO_UTF8(*m_VideoURL)))
+				{
+					UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 预取流打开失败, 反向播放退化为同步解码 url=%s"), *m_VideoURL);
+					m_PrefetchChunk.Remaining = 0;
+					return false;
+				}
+				if (bRawYUV)
+				{
+					m_PrefetchStream.set(cv::CAP_PROP_CONVERT_RGB, 0);
+				}
+			}
+			DecodeChunk(m_PrefetchStream, Start, End, m_PrefetchChunk);
+			return true;
+		});
+	return true;
+}
+
+void FInVideoDecoder::ResetReverseCache()
+{
+	m_ReverseChunk.Remaining = 0;
+	// 预取段正被后台写入时只做标记，由 FillReverseChunk 取回时丢弃
+	if (m_PrefetchFuture.IsValid())
+	{
+		m_bDiscardPrefetch = true;
+		return;
+	}
+	m_PrefetchChunk.Remaining = 0;
+}
+
+void FInVideoDecoder::CaptureLoopHead()
+{
+	// 只在正向从第 0 帧连续解码时缓存片头，深拷贝是因为读取缓冲会随队列复用；缓存的是缩放前的解码结果
+	const int32 HeadFrames = FMath::Min(m_LoopHeadFrames, m_TotalFrames - 1);
+	if (!m_bGaplessLoop || m_RealMode || m_bDecodingReverse || HeadFrames <= 0 || m_LoopHead.Num() >= HeadFrames
+		|| m_Frame.FrameIndex != m_LoopHead.Num() || m_bDiscardLoopStream)
+	{
+		return;
+	}
+	if (m_LoopHead.Num() == 0)
+	{
+		// 一次预留，避免扩容时按字节搬移 cv::Mat
+		m_LoopHead.Reserve(HeadFrames);
+	}
+	FInVideoFrame& Head = m_LoopHead.AddDefaulted_GetRef();
+	Head.Image = GetReadTarget().clone();
+	Head.FrameIndex = m_Frame.FrameIndex;
+	Head.PtsMs = m_Frame.PtsMs;
+	if (m_LoopHead.Num() == HeadFrames)
+	{
+		PrepareLoopStream();
+	}
+}
+
+void FInVideoDecoder::ResetLoopHead()
+{
+	m_LoopHead.Reset();
+	m_LoopHeadCursor = INDEX_NONE;
+	if (m_LoopStreamFuture.IsValid() && !m_LoopStreamFuture.IsReady())
+	{
+		m_bDiscardLoopStream = true;
+		return;
+	}
+	m_LoopStreamFuture = TFuture<bool>();
+	if (m_LoopStream.isOpened())
+	{
+		m_LoopStream.release();
+	}
+}
+
+void FInVideoDecoder::PollLoopStream()
+{
+	if (!m_bDiscardLoopStream || !m_LoopStreamFuture.IsReady())
+	{
+		return;
+	}
+	m_bDiscardLoopStream = false;
+	m_LoopStreamFuture = TFuture<bool>();
+	if (m_LoopStream.isOpened())
+	{
+		m_LoopStream.release();
+	}
+}
+
+bool FInVideoDecoder::TryGaplessWrap()
+{
+	if (!m_bGaplessLoop || m_LoopHead.Num() == 0
+		|| !m_LoopStreamFuture.IsValid() || !m_LoopStreamFuture.IsReady())
+	{
+		return false;
+	}
+	const bool bLoopStreamReady = m_LoopStreamFuture.Get();
+	m_LoopStreamFuture = TFuture<bool>();
+	if (!bLoopStreamReady)
+	{
+		return false;
+	}
+
+	Swap(m_Stream, m_LoopStream);
+	m_CurrentFrameIndex = 0;
+	m_LoopHeadCursor = 0;
+	// 换下来的流在后台重新定位到片头之后，供下一次回绕使用
+	PrepareLoopStream();
+	return true;
+}
+
+void FInVideoDecoder::PrepareLoopStream()
+{
+	const int32 ResumeFrame = m_LoopHead.Num();
+	m_LoopStreamFuture = Async(EAsyncExecution::ThreadPool, [this, ResumeFrame, bRawYUV = m_bRawYUV]()
+		{
+			if (!m_LoopStream.isOpened())
+			{
+				if (!m_LoopStream.open(TCHAR_TO_UTF8(*m_VideoURL)))
+				{
+					UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 备用循环流打开失败 url=%s"), *m_VideoURL);
+					return false;
+				}
+				if (bRawYUV)
+				{
+					m_LoopStream.set(cv::CAP_PROP_CONVERT_RGB, 0);
+				}
+			}
+			SeekToFrame(m_LoopStream, ResumeFrame);
+			return true;
+		});
+}
+
+int32 FInVideoDecoder::GetReverseChunkFrames() const
+{
+	// 当前段和预取段同时驻留，每段最多占一半预算
+	const double BytesPerPixel = m_bRawYUV ? 1.5 : 3.0;
+	const int64 FrameBytes = FMath::Max<int64>(1, (int64)(m_Width * (double)m_Height * BytesPerPixel));
+	const int32 BudgetFrames = (int32)FMath::Clamp<int64>(m_ReverseCacheBytes / 2 / FrameBytes, 1, MAX_int32);
+	// 有关键帧索引时段长只受内存预算限制，段边界由 GetReverseChunkStart 对齐到 GOP
+	return m_KeyframeIndex.IsValid() ? BudgetFrames : FMath::Clamp(m_ReverseGopFrames, 1, BudgetFrames);
+}
+
+int32 FInVideoDecoder::GetReverseChunkStart(int32 End) const
+{
+	const int32 MinStart = FMath::Max(0, End - GetReverseChunkFrames());
+	if (!m_KeyframeIndex.IsValid())
+	{
+		return MinStart;
+	}
+	// 取预算内第一个关键帧作为段起点，整段只需从关键帧顺序解码；单个 GOP 超出预算时退回 MinStart
+	int32 Keyframe = m_KeyframeIndex->GetKeyframeAtOrBefore(MinStart);
+	if (Keyframe < MinStart)
+	{
+		Keyframe = m_KeyframeIndex->GetNextKeyframe(MinStart);
+	}
+	return Keyframe < End ? Keyframe : MinStart;
+}
+
+void FInVideoDecoder::UpdateKeyframeIndex()
+{
+	if (!m_IndexFuture.IsValid() || !m_IndexFuture.IsReady())
+	{
+		return;
+	}
+	// 预取线程和备用循环流也会读取索引，等它们空闲时再切换，Tick 不等待
+	if ((m_PrefetchFuture.IsValid() && !m_PrefetchFuture.IsReady())
+		|| (m_LoopStreamFuture.IsValid() && !m_LoopStreamFuture.IsReady()))
+	{
+		return;
+	}
+	ResetReverseCache();
+	TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> Index = m_IndexFuture.Get();
+	m_IndexFuture = TFuture<TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe>>();
+	FScopeLock Lock(&m_StatsMutex);
+	m_KeyframeIndex = MoveTemp(Index);
+}
+
+void FInVideoDecoder::SeekToFrame(cv::VideoCapture& Stream, int32 FrameIndex)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InVideo_Seek);
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (m_KeyframeIndex.IsValid())
+	{
+		// 定位到关键帧只需解码一帧，再顺序 grab 已知的帧数
+		const int32 Keyframe = m_KeyframeIndex->GetKeyframeAtOrBefore(FrameIndex);
+		Stream.set(cv::CAP_PROP_POS_FRAMES, Keyframe);
+		for (int32 i = Keyframe; i < FrameIndex && false == m_Stopping; ++i)
+		{
+			if (!Stream.grab())
+			{
+				break;
+			}
+		}
+	}
+	else
+	{
+		Stream.set(cv::CAP_PROP_POS_FRAMES, FrameIndex);
+	}
+
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	FScopeLock Lock(&m_StatsMutex);
+	++m_SeekCount;
+	m_LastSeekMs = ElapsedMs;
+	m_TotalSeekMs += ElapsedMs;
+	m_MaxSeekMs = FMath::Max(m_MaxSeekMs, ElapsedMs);
+}
+
+double FInVideoDecoder::GetFrameDurationMs() const
+{
+	FScopeLock Lock(&m_StatsMutex);
+	return m_FrameDurationMs;
+}
+
+void FInVideoDecoder::GetStats(FInVideoPlayerStats& OutStats) const
+{
+	FScopeLock Lock(&m_StatsMutex);
+	OutStats.bHasKeyframeIndex = m_KeyframeIndex.IsValid();
+	OutStats.SeekCount = m_SeekCount;
+	OutStats.LastSeekMs = m_LastSeekMs;
+	OutStats.AverageSeekMs = m_SeekCount > 0 ? m_TotalSeekMs / m_SeekCount : 0.0;
+	OutStats.MaxSeekMs = m_MaxSeekMs;
+	OutStats.LiveDrainedFrames = m_LiveDrainedFrames;
+	OutStats.bReconnecting = m_bReconnecting;
+	OutStats.ReconnectAttempt = m_ReconnectAttempt;
+	OutStats.ReconnectCount = m_ReconnectCount;
+	OutStats.ThrottledFrames = m_ThrottledFrames;
+}
+
+bool FInVideoDecoder::IsNetworkURL(const FString& VideoURL)
+{
+	return VideoURL.Contains(TEXT("://")) && !VideoURL.StartsWith(TEXT("file://"), ESearchCase::IgnoreCase);
+}
+
+void FInVideoDecoder::ApplyPendingSeek()
+{
+	const int32 SeekIndex = m_PendingSeek.Exchange(INDEX_NONE);
+	if (SeekIndex == INDEX_NONE)
+	{
+		return;
+	}
+	m_CurrentFrameIndex = m_TotalFrames > 0 ? FMath::Clamp(SeekIndex, 0, m_TotalFrames - 1) : SeekIndex;
+	m_LoopHeadCursor = INDEX_NONE;
+	m_bFramePending = false;
+	ResetReverseCache();
+	if (m_bDecodingReverse)
+	{
+		// 反向时索引表示上一个交出的帧，下一次从 SeekIndex 开始倒序
+		m_CurrentFrameIndex += 1;
+	}
+	else
+	{
+		SeekToFrame(m_Stream, m_CurrentFrameIndex);
+	}
+	// 丢弃 Seek 之前解码好的帧
+	m_Ring.Clear();
+	if (OnSeekApplied)
+	{
+		OnSeekApplied();
+	}
+}
+
+void FInVideoDecoder::ConfigureNativeOutput()
+{
+	m_Width = (int32)m_Stream.get(cv::CAP_PROP_FRAME_WIDTH);
+	m_Height = (int32)m_Stream.get(cv::CAP_PROP_FRAME_HEIGHT);
+	m_bRawYUV = false;
+	// 解码时缩放也使用 YUV 输出，缩小后再转换颜色
+	if (!m_bNativeOutput && !m_bScaleOutput)
+	{
+		m_Stream.set(cv::CAP_PROP_CONVERT_RGB, 1);
+		return;
+	}
+
+	// 后端支持关闭 RGB 转换时，retrieve 返回解码器的 YUV420 数据
+	if (m_Stream.set(cv::CAP_PROP_CONVERT_RGB, 0))
+	{
+		const int32 PixelFormat = (int32)m_Stream.get(cv::CAP_PROP_CODEC_PIXEL_FORMAT);
+		m_RawLayout = PixelFormat == cv::VideoWriter::fourcc('N', 'V', '1', '2') ? EInVideoPlaneLayout::NV12 : EInVideoPlaneLayout::I420;
+		m_bRawYUV = true;
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 解码输出: %s"), m_bRawYUV ? TEXT("YUV420") : TEXT("BGR"));
+}
+
+void FInVideoDecoder::UpdateOutputScale()
+{
+	FIntPoint Requested;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		Requested = m_RequestedOutputSize;
+	}
+	// 只缩小：任一方向大于源尺寸时该方向保持原样，放大交给纹理采样
+	FIntPoint Size = FIntPoint::ZeroValue;
+	if (Requested != FIntPoint::ZeroValue && m_Width > 0 && m_Height > 0 && (Requested.X < m_Width || Requested.Y < m_Height))
+	{
+		Size = FIntPoint(FMath::Min(Requested.X, m_Width), FMath::Min(Requested.Y, m_Height));
+	}
+	if (Size == m_OutputSize)
+	{
+		return;
+	}
+	m_OutputSize = Size;
+	const bool bScale = Size != FIntPoint::ZeroValue;
+	UE_LOG(LogTemp, Log, TEXT("FInVideoDecoder 解码输出尺寸 %dx%d -> %dx%d url=%s"), m_Width, m_Height,
+		bScale ? Size.X : m_Width, bScale ? Size.Y : m_Height, *m_VideoURL);
+	if (bScale != m_bScaleOutput)
+	{
+		m_bScaleOutput = bScale;
+		if (!m_bNativeOutput && m_Stream.isOpened())
+		{
+			ConfigureNativeOutput();
+		}
+	}
+}
+
+bool FInVideoDecoder::ReadsToDecodeImage() const
+{
+	return m_bScaleOutput || (m_bRawYUV && !m_bNativeOutput);
+}
+
+cv::Mat& FInVideoDecoder::GetReadTarget()
+{
+	return ReadsToDecodeImage() ? m_DecodeImage : m_Frame.Image;
+}
+
+void FInVideoDecoder::ScaleToOutput()
+{
+	SCOPE_CYCLE_COUNTER(STAT_InVideo_DecodeScale);
+	if (!ReadsToDecodeImage())
+	{
+		return;
+	}
+	const bool bYUV = m_Frame.Layout != EInVideoPlaneLayout::PackedBGR;
+	const bool bToBGR = bYUV && !m_bNativeOutput;
+	const int32 SrcWidth = m_Frame.Width;
+	const int32 SrcHeight = m_Frame.Height;
+	int32 DstWidth = m_bScaleOutput ? m_OutputSize.X : SrcWidth;
+	int32 DstHeight = m_bScaleOutput ? m_OutputSize.Y : SrcHeight;
+
+	if (!bYUV)
+	{
+		// 后端不支持 YUV 输出时退回 BGR 上的面积插值
+		cv::resize(m_DecodeImage, m_Frame.Image, cv::Size(DstWidth, DstHeight), 0, 0, cv::INTER_AREA);
+	}
+	else
+	{
+		const int ColorCode = m_Frame.Layout == EInVideoPlaneLayout::NV12 ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2BGR_I420;
+		const cv::Mat* Planes = &m_DecodeImage;
+		if (DstWidth != SrcWidth || DstHeight != SrcHeight)
+		{
+			// 色度平面按 2x2 下采样，输出尺寸取偶数
+			DstWidth = FMath::Max(2, DstWidth & ~1);
+			DstHeight = FMath::Max(2, DstHeight & ~1);
+			cv::Mat& Scaled = bToBGR ? m_ScaledYUV : m_Frame.Image;
+			Scaled.create(DstHeight * 3 / 2, DstWidth, CV_8UC1);
+			ScaleYUV420(m_DecodeImage, SrcWidth, SrcHeight, m_Frame.Layout, Scaled, DstWidth, DstHeight);
+			Planes = &Scaled;
+		}
+		else if (!bToBGR)
+		{
+			m_DecodeImage.copyTo(m_Frame.Image);
+		}
+		if (bToBGR)
+		{
+			cv::cvtColor(*Planes, m_Frame.Image, ColorCode);
+			m_Frame.Layout = EInVideoPlaneLayout::PackedBGR;
+		}
+	}
+	m_Frame.Width = DstWidth;
+	m_Frame.Height = DstHeight;
+}
+
+bool FInVideoDecoder::ClassifyFrame()
+{
+	const cv::Mat& Image = GetReadTarget();
+	if (Image.type() == CV_8UC3)
+	{
+		m_Frame.Layout = EInVideoPlaneLayout::PackedBGR;
+		m_Frame.Width = Image.cols;
+		m_Frame.Height = Image.rows;
+		return true;
+	}
+	// 按上传时的平面布局检查数据量：奇数尺寸的色度向上取整，只有 m_Height * 3 / 2 行的帧装不下，不能交给上传路径
+	if (m_bRawYUV && Image.type() == CV_8UC1 && Image.isContinuous() && Image.cols == m_Width
+		&& InVideoPlanes::IsFrameComplete(m_RawLayout, m_Width, m_Height, (int64)Image.total()))
+	{
+		m_Frame.Layout = m_RawLayout;
+		m_Frame.Width = m_Width;
+		m_Frame.Height = m_Height;
+		return true;
+	}
+
+	// 后端返回了无法识别的布局，恢复 RGB 转换，下一帧起走 BGR 路径
+	UE_LOG(LogTemp, Warning, TEXT("FInVideoDecoder 无法识别的帧布局 type=%d %dx%d, 退回 BGR 输出"), Image.type(), Image.cols, Image.rows);
+	m_Stream.set(cv::CAP_PROP_CONVERT_RGB, 1);
+	m_bRawYUV = false;
+	// 已缓存的片头和备用流仍是 YUV 布局，重新缓存
+	ResetLoopHead();
+	return false;
+}
+
+double FInVideoDecoder::ReadPts(const cv::VideoCapture& Stream, int32 FrameIndex) const
+{
+	// read 之后 POS_MSEC 为刚解码帧的时间戳；部分后端恒返回 0，此时按帧号推算
+	const double PtsMs = Stream.get(cv::CAP_PROP_POS_MSEC);
+	return PtsMs > 0.0 || FrameIndex == 0 ? PtsMs : FrameIndex * m_FrameDurationMs;
+}
+
+void FInVideoDecoder::Fail()
+{
+	if (OnFailed)
+	{
+		OnFailed();
+	}
+}
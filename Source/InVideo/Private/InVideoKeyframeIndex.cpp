@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoKeyframeIndex.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/BufferArchive.h"
+#include "Serialization/MemoryReader.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include "PostOpenCVHeaders.h"
+
+namespace
+{
+	constexpr uint32 KeyframeIndexMagic = 0x464B5649; // "IVKF"
+	constexpr int32 KeyframeIndexVersion = 1;
+}
+
+TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> FInVideoKeyframeIndex::LoadOrBuild(const FString& VideoURL)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const int64 FileSize = FileManager.FileSize(*VideoURL);
+	if (FileSize <= 0)
+	{
+		return nullptr;
+	}
+	const int64 FileTimestamp = FileManager.GetTimeStamp(*VideoURL).GetTicks();
+	const FString CachePath = GetCachePath(VideoURL);
+
+	TSharedPtr<FInVideoKeyframeIndex, ESPMode::ThreadSafe> Index = MakeShared<FInVideoKeyframeIndex, ESPMode::ThreadSafe>();
+	if (Index->Load(CachePath, FileSize, FileTimestamp))
+	{
+		UE_LOG(LogTemp, Log, TEXT("FInVideoKeyframeIndex 加载缓存 %s 关键帧数: %d"), *CachePath, Index->GetNumKeyframes());
+		return Index;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Index->Build(VideoURL))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FInVideoKeyframeIndex 扫描失败 url=%s"), *VideoURL);
+		return nullptr;
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoKeyframeIndex 扫描完成 url=%s 帧数: %d 关键帧数: %d 耗时 %.1f ms"),
+		*VideoURL, Index->m_TotalFrames, Index->GetNumKeyframes(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	Index->Save(CachePath, FileSize, FileTimestamp);
+	return Index;
+}
+
+int32 FInVideoKeyframeIndex::GetKeyframeAtOrBefore(int32 FrameIndex) const
+{
+	if (m_FrameToKeyframe.Num() == 0)
+	{
+		return 0;
+	}
+	const int32 Clamped = FMath::Clamp(FrameIndex, 0, m_FrameToKeyframe.Num() - 1);
+	return m_KeyframeFrames[m_FrameToKeyframe[Clamped]];
+}
+
+int32 FInVideoKeyframeIndex::GetNextKeyframe(int32 FrameIndex) const
+{
+	if (m_FrameToKeyframe.Num() == 0)
+	{
+		return m_TotalFrames;
+	}
+	const int32 Clamped = FMath::Clamp(FrameIndex, 0, m_FrameToKeyframe.Num() - 1);
+	const int32 Next = m_FrameToKeyframe[Clamped] + 1;
+	return Next < m_KeyframeFrames.Num() ? m_KeyframeFrames[Next] : m_TotalFrames;
+}
+
+bool FInVideoKeyframeIndex::Build(const FString& VideoURL)
+{
+	// 原始包模式：read 返回未解码的压缩数据，扫描速度只受 IO 限制
+	cv::VideoCapture Stream;
+	const std::vector<int> Params = { cv::CAP_PROP_FORMAT, -1 };
+	if (!Stream.open(TCHAR_TO_UTF8(*VideoURL), cv::CAP_FFMPEG, Params))
+	{
+		return false;
+	}
+
+	m_KeyframeFrames.Reset();
+	m_KeyframeTimesMs.Reset();
+	cv::Mat Packet;
+	int32 FrameIndex = 0;
+	while (Stream.read(Packet))
+	{
+		if (Stream.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0)
+		{
+			m_KeyframeFrames.Add(FrameIndex);
+			m_KeyframeTimesMs.Add(Stream.get(cv::CAP_PROP_POS_MSEC));
+		}
+		++FrameIndex;
+	}
+	Stream.release();
+
+	m_TotalFrames = FrameIndex;
+	if (m_TotalFrames == 0 || m_KeyframeFrames.Num() == 0)
+	{
+		return false;
+	}
+	// 第一帧之前没有关键帧时按第 0 帧处理，保证查表总有结果
+	if (m_KeyframeFrames[0] != 0)
+	{
+		m_KeyframeFrames.Insert(0, 0);
+		m_KeyframeTimesMs.Insert(0.0, 0);
+	}
+	BuildLookup();
+	return true;
+}
+
+bool FInVideoKeyframeIndex::Load(const FString& CachePath, int64 FileSize, int64 FileTimestamp)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *CachePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int64 CachedSize = 0;
+	int64 CachedTimestamp = 0;
+	Reader << Magic << Version << CachedSize << CachedTimestamp;
+	if (Magic != KeyframeIndexMagic || Version != KeyframeIndexVersion
+		|| CachedSize != FileSize || CachedTimestamp != FileTimestamp)
+	{
+		return false;
+	}
+	Reader << m_TotalFrames << m_KeyframeFrames << m_KeyframeTimesMs;
+	if (Reader.IsError() || m_TotalFrames <= 0 || m_KeyframeFrames.Num() == 0
+		|| m_KeyframeFrames.Num() != m_KeyframeTimesMs.Num())
+	{
+		return false;
+	}
+	BuildLookup();
+	return true;
+}
+
+void FInVideoKeyframeIndex::Save(const FString& CachePath, int64 FileSize, int64 FileTimestamp) const
+{
+	FBufferArchive Writer;
+	uint32 Magic = KeyframeIndexMagic;
+	int32 Version = KeyframeIndexVersion;
+	int32 TotalFrames = m_TotalFrames;
+	TArray<int32> KeyframeFrames = m_KeyframeFrames;
+	TArray<double> KeyframeTimesMs = m_KeyframeTimesMs;
+	Writer << Magic << Version << FileSize << FileTimestamp << TotalFrames << KeyframeFrames << KeyframeTimesMs;
+	if (!FFileHelper::SaveArrayToFile(Writer, *CachePath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FInVideoKeyframeIndex 缓存写入失败 %s"), *CachePath);
+	}
+}
+
+void FInVideoKeyframeIndex::BuildLookup()
+{
+	m_FrameToKeyframe.SetNumUninitialized(m_TotalFrames);
+	int32 Keyframe = 0;
+	for (int32 Frame = 0; Frame < m_TotalFrames; ++Frame)
+	{
+		while (Keyframe + 1 < m_KeyframeFrames.Num() && m_KeyframeFrames[Keyframe + 1] <= Frame)
+		{
+			++Keyframe;
+		}
+		m_FrameToKeyframe[Frame] = Keyframe;
+	}
+}
+
+FString FInVideoKeyframeIndex::GetCachePath(const FString& VideoURL)
+{
+	const FString FullPath = FPaths::ConvertRelativePathToFull(VideoURL);
+	// 按 UTF-8 字节计算，HashAnsiString 会把非 ASCII 字符都变成 '?'，不同的中文路径会撞到同一个缓存
+	const FTCHARToUTF8 Utf8Path(*FullPath);
+	FMD5 Md5;
+	Md5.Update(reinterpret_cast<const uint8*>(Utf8Path.Get()), Utf8Path.Length());
+	uint8 Digest[16];
+	Md5.Final(Digest);
+	const FString Hash = BytesToHex(Digest, UE_ARRAY_COUNT(Digest));
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InVideo"), TEXT("KeyframeIndex"), Hash + TEXT(".kfi"));
+}
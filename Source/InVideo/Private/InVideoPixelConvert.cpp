@@ -0,0 +1,490 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoPixelConvert.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+#include <immintrin.h>
+#if PLATFORM_WINDOWS
+#include <intrin.h>
+#endif
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#define INVIDEO_CONVERT_NEON 1
+#endif
+
+#ifndef INVIDEO_CONVERT_NEON
+#define INVIDEO_CONVERT_NEON 0
+#endif
+
+// MSVC 不需要为单个函数开启指令集，Clang/GCC 需要
+#if PLATFORM_CPU_X86_FAMILY && (defined(__clang__) || defined(__GNUC__))
+#define INVIDEO_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define INVIDEO_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define INVIDEO_TARGET_SSSE3
+#define INVIDEO_TARGET_AVX2
+#endif
+
+namespace InVideoPixelConvert
+{
+	namespace
+	{
+		// 每个并行任务处理的目标字节数，约等于一块 L2 缓存
+		constexpr int32 ChunkBytes = 256 * 1024;
+
+		using FConvertRowFunc = void(*)(const uint8*, uint8*, int32);
+
+#if PLATFORM_CPU_X86_FAMILY
+		bool HasAVX2()
+		{
+#if PLATFORM_WINDOWS
+			int CpuInfo[4];
+			__cpuid(CpuInfo, 0);
+			if (CpuInfo[0] < 7)
+			{
+				return false;
+			}
+			__cpuid(CpuInfo, 1);
+			const bool bOSXSave = (CpuInfo[2] & (1 << 27)) != 0;
+			const bool bAVX = (CpuInfo[2] & (1 << 28)) != 0;
+			if (!bOSXSave || !bAVX || (_xgetbv(0) & 0x6) != 0x6)
+			{
+				return false;
+			}
+			__cpuidex(CpuInfo, 7, 0);
+			return (CpuInfo[1] & (1 << 5)) != 0;
+#elif defined(__clang__) || defined(__GNUC__)
+			return __builtin_cpu_supports("avx2");
+#else
+			return false;
+#endif
+		}
+
+		INVIDEO_TARGET_SSSE3 void BGRToBGRA_SSSE3(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			// 每 4 个像素 12 字节展开成 16 字节，第 4 字节由 Alpha 掩码填充
+			const __m128i Mask = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			const __m128i Alpha = _mm_set1_epi32(static_cast<int32>(0xFF000000));
+
+			int32 i = 0;
+			for (; i + 16 <= NumPixels; i += 16)
+			{
+				const __m128i In0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src));
+				const __m128i In1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 16));
+				const __m128i In2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 32));
+
+				const __m128i Px0 = In0;
+				const __m128i Px1 = _mm_alignr_epi8(In1, In0, 12);
+				const __m128i Px2 = _mm_alignr_epi8(In2, In1, 8);
+				const __m128i Px3 = _mm_srli_si128(In2, 4);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst), _mm_or_si128(_mm_shuffle_epi8(Px0, Mask), Alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + 16), _mm_or_si128(_mm_shuffle_epi8(Px1, Mask), Alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + 32), _mm_or_si128(_mm_shuffle_epi8(Px2, Mask), Alpha));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + 48), _mm_or_si128(_mm_shuffle_epi8(Px3, Mask), Alpha));
+
+				Src += 48;
+				Dst += 64;
+			}
+			BGRToBGRA_Scalar(Src, Dst, NumPixels - i);
+		}
+
+		INVIDEO_TARGET_AVX2 void BGRToBGRA_AVX2(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			// 每次读 32 字节，把第 0-2、3-5 个 DWORD 分别放到两个 128 位通道，再在通道内做 shuffle
+			const __m256i Permute = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+			const __m256i Mask = _mm256_setr_epi8(
+				0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+				0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+			const __m256i Alpha = _mm256_set1_epi32(static_cast<int32>(0xFF000000));
+
+			// 每次处理 8 个像素但读取 32 字节，末尾要留出 8 字节余量避免越界
+			int32 i = 0;
+			for (; i + 11 <= NumPixels; i += 8)
+			{
+				const __m256i In = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Src));
+				const __m256i Px = _mm256_permutevar8x32_epi32(In, Permute);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(Dst), _mm256_or_si256(_mm256_shuffle_epi8(Px, Mask), Alpha));
+				Src += 24;
+				Dst += 32;
+			}
+			BGRToBGRA_SSSE3(Src, Dst, NumPixels - i);
+		}
+
+		INVIDEO_TARGET_SSSE3 void BGRAToBGR_SSSE3(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			// 每个 16 字节的输入先在低 12 字节紧密排列，4 组再拼接成 48 字节输出
+			const __m128i Mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+			int32 i = 0;
+			for (; i + 16 <= NumPixels; i += 16)
+			{
+				const __m128i Px0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Src)), Mask);
+				const __m128i Px1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 16)), Mask);
+				const __m128i Px2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 32)), Mask);
+				const __m128i Px3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + 48)), Mask);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst), _mm_or_si128(Px0, _mm_slli_si128(Px1, 12)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + 16), _mm_or_si128(_mm_srli_si128(Px1, 4), _mm_slli_si128(Px2, 8)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + 32), _mm_or_si128(_mm_srli_si128(Px2, 8), _mm_slli_si128(Px3, 4)));
+
+				Src += 64;
+				Dst += 48;
+			}
+			BGRAToBGR_Scalar(Src, Dst, NumPixels - i);
+		}
+
+		INVIDEO_TARGET_AVX2 void BGRAToBGR_AVX2(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			// 通道内 shuffle 后每个 128 位通道低 12 字节有效，再用 permute 把两段并到低 24 字节
+			const __m256i Mask = _mm256_setr_epi8(
+				0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+				0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			const __m256i Permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+			int32 i = 0;
+			for (; i + 8 <= NumPixels; i += 8)
+			{
+				const __m256i In = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Src));
+				const __m256i Px = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(In, Mask), Permute);
+				// 只写 24 字节，不越过目标行尾
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst), _mm256_castsi256_si128(Px));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(Dst + 16), _mm256_extracti128_si256(Px, 1));
+				Src += 32;
+				Dst += 24;
+			}
+			BGRAToBGR_SSSE3(Src, Dst, NumPixels - i);
+		}
+#endif
+
+#if INVIDEO_CONVERT_NEON
+		void BGRToBGRA_NEON(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			const uint8x16_t Alpha = vdupq_n_u8(255);
+			int32 i = 0;
+			for (; i + 16 <= NumPixels; i += 16)
+			{
+				const uint8x16x3_t In = vld3q_u8(Src);
+				uint8x16x4_t Out;
+				Out.val[0] = In.val[0];
+				Out.val[1] = In.val[1];
+				Out.val[2] = In.val[2];
+				Out.val[3] = Alpha;
+				vst4q_u8(Dst, Out);
+				Src += 48;
+				Dst += 64;
+			}
+			BGRToBGRA_Scalar(Src, Dst, NumPixels - i);
+		}
+
+		void BGRAToBGR_NEON(const uint8* Src, uint8* Dst, int32 NumPixels)
+		{
+			int32 i = 0;
+			for (; i + 16 <= NumPixels; i += 16)
+			{
+				const uint8x16x4_t In = vld4q_u8(Src);
+				uint8x16x3_t Out;
+				Out.val[0] = In.val[0];
+				Out.val[1] = In.val[1];
+				Out.val[2] = In.val[2];
+				vst3q_u8(Dst, Out);
+				Src += 64;
+				Dst += 48;
+			}
+			BGRAToBGR_Scalar(Src, Dst, NumPixels - i);
+		}
+#endif
+
+		struct FKernel
+		{
+			FConvertRowFunc BGRToBGRA = &BGRToBGRA_Scalar;
+			FConvertRowFunc BGRAToBGR = &BGRAToBGR_Scalar;
+			const TCHAR* Name = TEXT("Scalar");
+
+			FKernel()
+			{
+#if PLATFORM_CPU_X86_FAMILY
+				if (HasAVX2())
+				{
+					BGRToBGRA = &BGRToBGRA_AVX2;
+					BGRAToBGR = &BGRAToBGR_AVX2;
+					Name = TEXT("AVX2");
+				}
+				else
+				{
+					BGRToBGRA = &BGRToBGRA_SSSE3;
+					BGRAToBGR = &BGRAToBGR_SSSE3;
+					Name = TEXT("SSSE3");
+				}
+#elif INVIDEO_CONVERT_NEON
+				BGRToBGRA = &BGRToBGRA_NEON;
+				BGRAToBGR = &BGRAToBGR_NEON;
+				Name = TEXT("NEON");
+#endif
+			}
+		};
+
+		const FKernel& GetKernel()
+		{
+			static const FKernel Kernel;
+			return Kernel;
+		}
+	}
+
+	void BGRToBGRA_Scalar(const uint8* Src, uint8* Dst, int32 NumPixels)
+	{
+		for (int32 i = 0; i < NumPixels; ++i)
+		{
+			Dst[0] = Src[0];
+			Dst[1] = Src[1];
+			Dst[2] = Src[2];
+			Dst[3] = 255;
+			Src += 3;
+			Dst += 4;
+		}
+	}
+
+	void BGRToBGRA(const uint8* Src, uint8* Dst, int32 NumPixels)
+	{
+		GetKernel().BGRToBGRA(Src, Dst, NumPixels);
+	}
+
+	void BGRToBGRAImage(const uint8* Src, int32 SrcStride, uint8* Dst, int32 DstStride, int32 Width, int32 Height)
+	{
+		if (Width <= 0 || Height <= 0)
+		{
+			return;
+		}
+		const FConvertRowFunc Convert = GetKernel().BGRToBGRA;
+		const int32 RowsPerChunk = FMath::Clamp(ChunkBytes / (Width * 4), 1, Height);
+		const int32 NumChunks = FMath::DivideAndRoundUp(Height, RowsPerChunk);
+
+		ParallelFor(NumChunks, [=](int32 Chunk)
+			{
+				const int32 FirstRow = Chunk * RowsPerChunk;
+				const int32 LastRow = FMath::Min(FirstRow + RowsPerChunk, Height);
+				for (int32 y = FirstRow; y < LastRow; ++y)
+				{
+					Convert(Src + (int64)y * SrcStride, Dst + (int64)y * DstStride, Width);
+				}
+			});
+	}
+
+	void BGRAToBGR_Scalar(const uint8* Src, uint8* Dst, int32 NumPixels)
+	{
+		for (int32 i = 0; i < NumPixels; ++i)
+		{
+			Dst[0] = Src[0];
+			Dst[1] = Src[1];
+			Dst[2] = Src[2];
+			Src += 4;
+			Dst += 3;
+		}
+	}
+
+	void BGRAToBGR(const uint8* Src, uint8* Dst, int32 NumPixels)
+	{
+		GetKernel().BGRAToBGR(Src, Dst, NumPixels);
+	}
+
+	void BGRAToBGRImage(const uint8* Src, int32 SrcStride, uint8* Dst, int32 DstStride, int32 Width, int32 Height)
+	{
+		if (Width <= 0 || Height <= 0)
+		{
+			return;
+		}
+		const FConvertRowFunc Convert = GetKernel().BGRAToBGR;
+		const int32 RowsPerChunk = FMath::Clamp(ChunkBytes / (Width * 4), 1, Height);
+		const int32 NumChunks = FMath::DivideAndRoundUp(Height, RowsPerChunk);
+
+		ParallelFor(NumChunks, [=](int32 Chunk)
+			{
+				const int32 FirstRow = Chunk * RowsPerChunk;
+				const int32 LastRow = FMath::Min(FirstRow + RowsPerChunk, Height);
+				for (int32 y = FirstRow; y < LastRow; ++y)
+				{
+					Convert(Src + (int64)y * SrcStride, Dst + (int64)y * DstStride, Width);
+				}
+			});
+	}
+
+	void DownsampleBGRA2x2(const uint8* Src, int32 SrcStride, int32 SrcWidth, int32 SrcHeight, uint8* Dst, int32 DstStride)
+	{
+		if (SrcWidth <= 0 || SrcHeight <= 0)
+		{
+			return;
+		}
+		const int32 DstWidth = FMath::Max(1, SrcWidth / 2);
+		const int32 DstHeight = FMath::Max(1, SrcHeight / 2);
+		// 每个目标行读两行源数据
+		const int32 RowsPerChunk = FMath::Clamp(ChunkBytes / (SrcWidth * 8), 1, DstHeight);
+		const int32 NumChunks = FMath::DivideAndRoundUp(DstHeight, RowsPerChunk);
+
+		ParallelFor(NumChunks, [=](int32 Chunk)
+			{
+				const int32 FirstRow = Chunk * RowsPerChunk;
+				const int32 LastRow = FMath::Min(FirstRow + RowsPerChunk, DstHeight);
+				for (int32 y = FirstRow; y < LastRow; ++y)
+				{
+					const uint8* Row0 = Src + (int64)FMath::Min(y * 2, SrcHeight - 1) * SrcStride;
+					const uint8* Row1 = Src + (int64)FMath::Min(y * 2 + 1, SrcHeight - 1) * SrcStride;
+					uint8* Out = Dst + (int64)y * DstStride;
+					for (int32 x = 0; x < DstWidth; ++x)
+					{
+						const int32 X0 = FMath::Min(x * 2, SrcWidth - 1) * 4;
+						const int32 X1 = FMath::Min(x * 2 + 1, SrcWidth - 1) * 4;
+						for (int32 c = 0; c < 4; ++c)
+						{
+							Out[c] = (uint8)((Row0[X0 + c] + Row0[X1 + c] + Row1[X0 + c] + Row1[X1 + c] + 2) >> 2);
+						}
+						Out += 4;
+					}
+				}
+			});
+	}
+
+	const TCHAR* GetKernelName()
+	{
+		return GetKernel().Name;
+	}
+}
+
+namespace
+{
+	void MeasureConvert(const TCHAR* Command, const TCHAR* Name, int32 Iterations, double BytesPerIteration, TFunctionRef<void()> Body)
+	{
+		Body(); // 预热
+		const double Start = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; ++i)
+		{
+			Body();
+		}
+		const double Seconds = FPlatformTime::Seconds() - Start;
+		UE_LOG(LogTemp, Log, TEXT("%s %-24s %8.3f ms/frame %8.2f GB/s"),
+			Command, Name, Seconds * 1000.0 / Iterations, BytesPerIteration * Iterations / Seconds / 1.0e9);
+	}
+
+	// 用法: InVideo.BenchPixelConvert [Width] [Height] [Iterations]
+	void BenchPixelConvert(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 3840;
+		const int32 Height = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 2160;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 20;
+		const int32 NumPixels = Width * Height;
+		if (NumPixels <= 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("InVideo.BenchPixelConvert 无效尺寸 %dx%d"), Width, Height);
+			return;
+		}
+
+		TArray<uint8> Src;
+		Src.SetNumUninitialized(NumPixels * 3);
+		FRandomStream Random(1234);
+		for (uint8& Byte : Src)
+		{
+			Byte = (uint8)Random.RandRange(0, 255);
+		}
+		TArray<uint8> Reference;
+		Reference.SetNumUninitialized(NumPixels * 4);
+		TArray<uint8> Dst;
+		Dst.SetNumUninitialized(NumPixels * 4);
+
+		// 读 3 字节写 4 字节
+		const double BytesPerIteration = (double)NumPixels * 7.0;
+		auto Measure = [&](const TCHAR* Name, TFunctionRef<void()> Body)
+			{
+				MeasureConvert(TEXT("InVideo.BenchPixelConvert"), Name, Iterations, BytesPerIteration, Body);
+			};
+
+		UE_LOG(LogTemp, Log, TEXT("InVideo.BenchPixelConvert %dx%d x%d kernel=%s"), Width, Height, Iterations, InVideoPixelConvert::GetKernelName());
+
+		Measure(TEXT("Scalar"), [&]() { InVideoPixelConvert::BGRToBGRA_Scalar(Src.GetData(), Reference.GetData(), NumPixels); });
+		Measure(TEXT("SIMD 1 thread"), [&]() { InVideoPixelConvert::BGRToBGRA(Src.GetData(), Dst.GetData(), NumPixels); });
+		const bool bSingleMatch = FMemory::Memcmp(Reference.GetData(), Dst.GetData(), Dst.Num()) == 0;
+
+		FMemory::Memzero(Dst.GetData(), Dst.Num());
+		Measure(TEXT("SIMD row chunks"), [&]() { InVideoPixelConvert::BGRToBGRAImage(Src.GetData(), Width * 3, Dst.GetData(), Width * 4, Width, Height); });
+		const bool bImageMatch = FMemory::Memcmp(Reference.GetData(), Dst.GetData(), Dst.Num()) == 0;
+
+		UE_LOG(LogTemp, Log, TEXT("InVideo.BenchPixelConvert 结果校验 SIMD=%s Image=%s"),
+			bSingleMatch ? TEXT("OK") : TEXT("MISMATCH"), bImageMatch ? TEXT("OK") : TEXT("MISMATCH"));
+	}
+
+	FAutoConsoleCommand BenchPixelConvertCommand(
+		TEXT("InVideo.BenchPixelConvert"),
+		TEXT("测量像素格式转换吞吐量. 参数: [Width] [Height] [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchPixelConvert));
+
+	// 用法: InVideo.BenchRecordConvert [Width] [Height] [Iterations]
+	// 录制路径的 BGRA => BGR，与原先逐元素索引 TArray<FColor> 的循环对比
+	void BenchRecordConvert(const TArray<FString>& Args)
+	{
+		const int32 Width = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 3840;
+		const int32 Height = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 2160;
+		const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 20;
+		const int32 NumPixels = Width * Height;
+		if (NumPixels <= 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("InVideo.BenchRecordConvert 无效尺寸 %dx%d"), Width, Height);
+			return;
+		}
+
+		TArray<FColor> Src;
+		Src.SetNumUninitialized(NumPixels);
+		FRandomStream Random(1234);
+		for (FColor& Color : Src)
+		{
+			Color = FColor(Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255));
+		}
+		TArray<uint8> Reference;
+		Reference.SetNumUninitialized(NumPixels * 3);
+		TArray<uint8> Dst;
+		Dst.SetNumUninitialized(NumPixels * 3);
+		const uint8* SrcBytes = reinterpret_cast<const uint8*>(Src.GetData());
+
+		// 读 4 字节写 3 字节
+		const double BytesPerIteration = (double)NumPixels * 7.0;
+		auto Measure = [&](const TCHAR* Name, TFunctionRef<void()> Body)
+			{
+				MeasureConvert(TEXT("InVideo.BenchRecordConvert"), Name, Iterations, BytesPerIteration, Body);
+			};
+
+		UE_LOG(LogTemp, Log, TEXT("InVideo.BenchRecordConvert %dx%d x%d kernel=%s"), Width, Height, Iterations, InVideoPixelConvert::GetKernelName());
+
+		Measure(TEXT("Legacy TArray loop"), [&]()
+			{
+				char* ImageBuf = reinterpret_cast<char*>(Reference.GetData());
+				int count = 0;
+				for (int i = 0; i < Src.Num(); i++)
+				{
+					ImageBuf[count] = Src[i].B;
+					ImageBuf[count + 1] = Src[i].G;
+					ImageBuf[count + 2] = Src[i].R;
+					count += 3;
+				}
+			});
+		Measure(TEXT("Scalar"), [&]() { InVideoPixelConvert::BGRAToBGR_Scalar(SrcBytes, Dst.GetData(), NumPixels); });
+		const bool bScalarMatch = FMemory::Memcmp(Reference.GetData(), Dst.GetData(), Dst.Num()) == 0;
+
+		FMemory::Memzero(Dst.GetData(), Dst.Num());
+		Measure(TEXT("SIMD 1 thread"), [&]() { InVideoPixelConvert::BGRAToBGR(SrcBytes, Dst.GetData(), NumPixels); });
+		const bool bSingleMatch = FMemory::Memcmp(Reference.GetData(), Dst.GetData(), Dst.Num()) == 0;
+
+		FMemory::Memzero(Dst.GetData(), Dst.Num());
+		Measure(TEXT("SIMD row chunks"), [&]() { InVideoPixelConvert::BGRAToBGRImage(SrcBytes, Width * 4, Dst.GetData(), Width * 3, Width, Height); });
+		const bool bImageMatch = FMemory::Memcmp(Reference.GetData(), Dst.GetData(), Dst.Num()) == 0;
+
+		UE_LOG(LogTemp, Log, TEXT("InVideo.BenchRecordConvert 结果校验 Scalar=%s SIMD=%s Image=%s"),
+			bScalarMatch ? TEXT("OK") : TEXT("MISMATCH"), bSingleMatch ? TEXT("OK") : TEXT("MISMATCH"), bImageMatch ? TEXT("OK") : TEXT("MISMATCH"));
+	}
+
+	FAutoConsoleCommand BenchRecordConvertCommand(
+		TEXT("InVideo.BenchRecordConvert"),
+		TEXT("测量录制路径 BGRA=>BGR 转换吞吐量. 参数: [Width] [Height] [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchRecordConvert));
+}
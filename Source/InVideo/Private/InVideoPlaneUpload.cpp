@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoPlaneUpload.h"
+#include "InVideoConvertShader.h"
+#include "GlobalShader.h"
+#include "PixelShaderUtils.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "ShaderParameterStruct.h"
+#include "TextureResource.h"
+
+namespace InVideoPlanes
+{
+	void GetPlaneLayout(EInVideoPlaneLayout Layout, int32 Width, int32 Height, FInVideoPlaneDescArray& OutPlanes)
+	{
+		OutPlanes.Reset();
+		// 色度按 2x2 下采样，奇数尺寸向上取整，与 FFmpeg 的 YUV420 布局一致
+		const int32 ChromaWidth = (Width + 1) / 2;
+		const int32 ChromaHeight = (Height + 1) / 2;
+		const int64 LumaBytes = (int64)Width * Height;
+
+		switch (Layout)
+		{
+		case EInVideoPlaneLayout::PackedBGR:
+			// 每个像素 3 字节，作为 3 倍宽的单通道纹理上传，着色器按 3 个texel 读取一个像素
+			OutPlanes.Add({ Width * 3, Height, PF_G8, 1, 0, Width * 3 });
+			break;
+		case EInVideoPlaneLayout::I420:
+			OutPlanes.Add({ Width, Height, PF_G8, 1, 0, Width });
+			OutPlanes.Add({ ChromaWidth, ChromaHeight, PF_G8, 1, LumaBytes, ChromaWidth });
+			OutPlanes.Add({ ChromaWidth, ChromaHeight, PF_G8, 1, LumaBytes + (int64)ChromaWidth * ChromaHeight, ChromaWidth });
+			break;
+		case EInVideoPlaneLayout::NV12:
+			OutPlanes.Add({ Width, Height, PF_G8, 1, 0, Width });
+			OutPlanes.Add({ ChromaWidth, ChromaHeight, PF_R8G8, 2, LumaBytes, ChromaWidth * 2 });
+			break;
+		}
+	}
+
+	int64 GetFrameBytes(EInVideoPlaneLayout Layout, int32 Width, int32 Height)
+	{
+		FInVideoPlaneDescArray Planes;
+		GetPlaneLayout(Layout, Width, Height, Planes);
+		int64 Bytes = 0;
+		for (const FInVideoPlaneDesc& Plane : Planes)
+		{
+			Bytes = FMath::Max(Bytes, Plane.Offset + (int64)Plane.Pitch * Plane.Height);
+		}
+		return Bytes;
+	}
+
+	bool IsFrameComplete(EInVideoPlaneLayout Layout, int32 Width, int32 Height, int64 Bytes)
+	{
+		return Width > 0 && Height > 0 && Bytes >= GetFrameBytes(Layout, Width, Height);
+	}
+}
+
+void FInVideoPlaneTextures::EnsurePlanes(const FInVideoPlaneDescArray& Planes)
+{
+	for (int32 i = 0; i < Planes.Num(); ++i)
+	{
+		const FInVideoPlaneDesc& Desc = Planes[i];
+		if (m_Planes[i].IsValid()
+			&& m_PlaneDescs[i].Width == Desc.Width
+			&& m_PlaneDescs[i].Height == Desc.Height
+			&& m_PlaneDescs[i].Format == Desc.Format)
+		{
+			continue;
+		}
+		const FRHITextureCreateDesc CreateDesc =
+			FRHITextureCreateDesc::Create2D(TEXT("InVideoPlane"), Desc.Width, Desc.Height, Desc.Format)
+			.SetFlags(ETextureCreateFlags::ShaderResource);
+		m_Planes[i] = RHICreateTexture(CreateDesc);
+		m_PlaneDescs[i] = Desc;
+	}
+}
+
+void FInVideoPlaneTextures::UploadAndConvert(FRHICommandListImmediate& RHICmdList, EInVideoPlaneLayout Layout,
+	int32 Width, int32 Height, const uint8* Data, FTextureRenderTargetResource* Target)
+{
+	check(IsInRenderingThread());
+	if (nullptr == Target || nullptr == Data || Width <= 0 || Height <= 0)
+	{
+		return;
+	}
+
+	FInVideoPlaneDescArray Planes;
+	InVideoPlanes::GetPlaneLayout(Layout, Width, Height, Planes);
+	EnsurePlanes(Planes);
+
+	for (int32 i = 0; i < Planes.Num(); ++i)
+	{
+		const FInVideoPlaneDesc& Desc = Planes[i];
+		const FUpdateTextureRegion2D Region(0, 0, 0, 0, Desc.Width, Desc.Height);
+		RHIUpdateTexture2D(m_Planes[i], 0, Region, Desc.Pitch, Data + Desc.Offset);
+	}
+
+	FTexture2DRHIRef TargetTexture = Target->GetRenderTargetTexture();
+	if (!TargetTexture.IsValid())
+	{
+		return;
+	}
+	const FIntPoint OutputSize = TargetTexture->GetSizeXY();
+
+	FRDGBuilder GraphBuilder(RHICmdList);
+	FRDGTextureRef Output = RegisterExternalTexture(GraphBuilder, TargetTexture, TEXT("InVideoOutput"));
+
+	FInVideoConvertPS::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FInVideoConvertPS::FLayoutDim>((int32)Layout);
+	TShaderMapRef<FInVideoConvertPS> PixelShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+	FInVideoConvertPS::FParameters* Parameters = GraphBuilder.AllocParameters<FInVideoConvertPS::FParameters>();
+	// 未使用的平面绑定亮度平面占位
+	Parameters->PlaneY = m_Planes[0];
+	Parameters->PlaneU = Planes.Num() > 1 ? m_Planes[1] : m_Planes[0];
+	Parameters->PlaneV = Planes.Num() > 2 ? m_Planes[2] : m_Planes[0];
+	Parameters->PlaneSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp>::GetRHI();
+	Parameters->SourceSize = FIntPoint(Width, Height);
+	Parameters->InvOutputSize = FVector2f(1.0f / OutputSize.X, 1.0f / OutputSize.Y);
+	// 高清及以上按 BT.709，标清按 BT.601
+	Parameters->bBT709 = Height >= 720 ? 1 : 0;
+	Parameters->RenderTargets[0] = FRenderTargetBinding(Output, ERenderTargetLoadAction::ENoAction);
+
+	FPixelShaderUtils::AddFullscreenPass(GraphBuilder, GetGlobalShaderMap(GMaxRHIFeatureLevel),
+		RDG_EVENT_NAME("InVideoConvert"), PixelShader, Parameters, FIntRect(FIntPoint::ZeroValue, OutputSize));
+
+	GraphBuilder.Execute();
+}
@@ -0,0 +1,521 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoSource.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/imgproc.hpp>
+#include "PostOpenCVHeaders.h"
+
+namespace
+{
+	// 共享源注册表，键为规范化 URL + 解码选项；源由订阅者持有，最后一个释放时从表中移除
+	FCriticalSection GSourcesMutex;
+	TMap<FString, TWeakPtr<FInVideoSource, ESPMode::ThreadSafe>> GSources;
+}
+
+FString FInVideoSourceOptions::MakeKey(const FString& VideoURL) const
+{
+	return FString::Printf(TEXT("%s|rt=%d|native=%d|live=%d|loop=%d|rev=%d"), *FInVideoSource::NormalizeURL(VideoURL),
+		bRealMode ? 1 : 0, bNativeOutput ? 1 : 0, bLive ? 1 : 0, bGaplessLoop ? LoopHeadFrames : 0, bReverse ? 1 : 0);
+}
+
+FString FInVideoSource::NormalizeURL(const FString& VideoURL)
+{
+	FString Normalized = VideoURL.TrimStartAndEnd();
+	if (Normalized.Contains(TEXT("://")))
+	{
+		return Normalized;
+	}
+	Normalized = FPaths::ConvertRelativePathToFull(Normalized);
+	FPaths::NormalizeFilename(Normalized);
+#if PLATFORM_WINDOWS
+	// Windows 文件名不区分大小写
+	Normalized.ToLowerInline();
+#endif
+	return Normalized;
+}
+
+FInVideoSource::FSourceRef FInVideoSource::Acquire(const FString& VideoURL, const FInVideoSourceOptions& Options, bool bShared)
+{
+	if (!bShared)
+	{
+		return MakeShareable(new FInVideoSource(VideoURL, FString(), Options));
+	}
+
+	const FString Key = Options.MakeKey(VideoURL);
+	FScopeLock Lock(&GSourcesMutex);
+	if (const TWeakPtr<FInVideoSource, ESPMode::ThreadSafe>* Found = GSources.Find(Key))
+	{
+		FSourceRef Existing = Found->Pin();
+		// 已失败的源不再复用，重新打开
+		if (Existing.IsValid() && !Existing->m_bFailed)
+		{
+			UE_LOG(LogTemp, Log, TEXT("FInVideoSource 复用共享解码源 %s"), *Key);
+			// 键只包含初始方向，共享源的方向可能已被其他控件在运行时切换
+			bool bExistingReverse = false;
+			{
+				FScopeLock SourceLock(&Existing->m_Mutex);
+				bExistingReverse = Existing->m_bReverse;
+			}
+			if (bExistingReverse != Options.bReverse)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("FInVideoSource 共享源当前为%s播放, 与请求的方向不一致, 按共享源的方向播放 %s"),
+					bExistingReverse ? TEXT("反向") : TEXT("正向"), *Key);
+			}
+			return Existing;
+		}
+	}
+	FSourceRef Source = MakeShareable(new FInVideoSource(VideoURL, Key, Options));
+	GSources.Add(Key, Source);
+	return Source;
+}
+
+FInVideoSource::FInVideoSource(const FString& VideoURL, const FString& Key, const FInVideoSourceOptions& Options)
+	: m_VideoURL(VideoURL)
+	, m_Key(Key)
+	, m_Options(Options)
+	, m_bReverse(Options.bReverse)
+{
+	// 直播只关心最新帧，分发跟不上时覆盖旧帧
+	m_Ring.Reset(1, Options.bLive ? EInVideoQueueFullPolicy::DropOldest : EInVideoQueueFullPolicy::Block);
+	m_Decoder = MakeUnique<FInVideoDecoder>(m_Ring);
+	m_Decoder->SetReverse(Options.bReverse);
+	m_Decoder->SetNativeOutput(Options.bNativeOutput);
+	m_Decoder->SetReverseCacheBudget(Options.ReverseCacheBytes);
+	m_Decoder->SetGaplessLoop(Options.bGaplessLoop, Options.LoopHeadFrames);
+	m_Decoder->SetLiveMode(Options.bLive, Options.OpenTimeoutMs, Options.ReadTimeoutMs);
+	m_Decoder->SetReconnect(Options.bAutoReconnect, Options.ReconnectInitialDelay, Options.ReconnectMaxDelay, Options.ReconnectMaxAttempts);
+
+	m_Decoder->OnFramePushed = [this]()
+		{
+			FScopeLock Lock(&m_Mutex);
+			FanOut();
+		};
+	m_Decoder->OnSeekApplied = [this]() { HandleSeekApplied(); };
+	m_Decoder->OnFailed = [this]()
+		{
+			m_bFailed = true;
+			FScopeLock Lock(&m_Mutex);
+			for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+			{
+				if (Entry->Subscriber.OnFailed)
+				{
+					Entry->Subscriber.OnFailed();
+				}
+			}
+		};
+	m_Decoder->OnReachedEnd = [this]() { HandleReachedEnd(); };
+	m_Decoder->OnReconnecting = [this](int32 Attempt, float DelaySeconds)
+		{
+			FScopeLock Lock(&m_Mutex);
+			for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+			{
+				if (Entry->Subscriber.OnReconnecting)
+				{
+					Entry->Subscriber.OnReconnecting(Attempt, DelaySeconds);
+				}
+			}
+		};
+	m_Decoder->OnRecovered = [this]()
+		{
+			FScopeLock Lock(&m_Mutex);
+			for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+			{
+				if (Entry->Subscriber.OnRecovered)
+				{
+					Entry->Subscriber.OnRecovered();
+				}
+			}
+		};
+}
+
+FInVideoSource::~FInVideoSource()
+{
+	// 先停解码，回调里会访问订阅者列表
+	m_Decoder.Reset();
+	if (!m_Key.IsEmpty())
+	{
+		FScopeLock Lock(&GSourcesMutex);
+		const TWeakPtr<FInVideoSource, ESPMode::ThreadSafe>* Found = GSources.Find(m_Key);
+		// 同一个键可能已经换成了新打开的源
+		if (Found != nullptr && !Found->IsValid())
+		{
+			GSources.Remove(m_Key);
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoSource 释放解码源 url=%s"), *m_VideoURL);
+}
+
+int32 FInVideoSource::Subscribe(FInVideoSourceSubscriber Subscriber)
+{
+	bool bStart = false;
+	int32 SubscriberId = INDEX_NONE;
+	{
+		FScopeLock Lock(&m_Mutex);
+		TUniquePtr<FSubscriberEntry>& Entry = m_Subscribers.Add_GetRef(MakeUnique<FSubscriberEntry>());
+		Entry->Id = SubscriberId = m_NextSubscriberId++;
+		Entry->Subscriber = MoveTemp(Subscriber);
+		UpdateDecoderPaused();
+		UpdateDecoderThrottle();
+		UpdateDecoderOutputSize();
+		bStart = !m_bStarted;
+		m_bStarted = true;
+		UE_LOG(LogTemp, Log, TEXT("FInVideoSource 订阅 url=%s 订阅者 %d 个"), *m_VideoURL, m_Subscribers.Num());
+	}
+	if (bStart)
+	{
+		// Start 注册解码任务，不在锁内调用，首帧的分发会等待锁
+		m_Decoder->Start(m_VideoURL, m_Options.bRealMode);
+	}
+	return SubscriberId;
+}
+
+void FInVideoSource::Unsubscribe(int32 SubscriberId)
+{
+	FScopeLock Lock(&m_Mutex);
+	m_Subscribers.RemoveAll([SubscriberId](const TUniquePtr<FSubscriberEntry>& Entry) { return Entry->Id == SubscriberId; });
+	PruneScaledImages();
+	UpdateDecoderPaused();
+	UpdateDecoderThrottle();
+	UpdateDecoderOutputSize();
+	// 等待中的帧可能正是被移除的订阅者挡住的
+	FanOut();
+}
+
+void FInVideoSource::SetOutputSize(int32 SubscriberId, FIntPoint OutputSize, bool bShrinkOnly)
+{
+	FScopeLock Lock(&m_Mutex);
+	if (FSubscriberEntry* Entry = FindSubscriber(SubscriberId))
+	{
+		Entry->Subscriber.OutputSize = OutputSize.X > 0 && OutputSize.Y > 0 ? OutputSize : FIntPoint::ZeroValue;
+		Entry->Subscriber.bShrinkOnly = bShrinkOnly;
+		PruneScaledImages();
+		UpdateDecoderOutputSize();
+	}
+}
+
+void FInVideoSource::SetSubscriberPaused(int32 SubscriberId, bool bPaused)
+{
+	FScopeLock Lock(&m_Mutex);
+	if (FSubscriberEntry* Entry = FindSubscriber(SubscriberId))
+	{
+		Entry->Subscriber.bPaused = bPaused;
+		UpdateDecoderPaused();
+		FanOut();
+	}
+}
+
+void FInVideoSource::SetSubscriberThrottle(int32 SubscriberId, EInVideoDecodeThrottle Throttle, float MaxFps)
+{
+	FScopeLock Lock(&m_Mutex);
+	if (FSubscriberEntry* Entry = FindSubscriber(SubscriberId))
+	{
+		Entry->Subscriber.Throttle = Throttle;
+		Entry->Subscriber.ThrottleFps = MaxFps;
+		UpdateDecoderThrottle();
+		// 挂起的订阅者不再挡住等待中的帧
+		FanOut();
+	}
+}
+
+void FInVideoSource::Seek(int32 FrameIndex)
+{
+	m_Decoder->Seek(FrameIndex);
+}
+
+void FInVideoSource::SetReverse(bool bReverse)
+{
+	m_Decoder->SetReverse(bReverse);
+	FScopeLock Lock(&m_Mutex);
+	m_bReverse = bReverse;
+	for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		// 换向后帧号不再连续，不按回绕处理
+		Entry->LastFrame = INDEX_NONE;
+		if (Entry->Subscriber.OnReverseChanged)
+		{
+			Entry->Subscriber.OnReverseChanged(bReverse);
+		}
+	}
+}
+
+void FInVideoSource::OnSubscriberPopped()
+{
+	FScopeLock Lock(&m_Mutex);
+	FanOut();
+}
+
+double FInVideoSource::GetFrameDurationMs() const
+{
+	return m_Decoder->GetFrameDurationMs();
+}
+
+void FInVideoSource::GetStats(FInVideoPlayerStats& OutStats) const
+{
+	m_Decoder->GetStats(OutStats);
+	FScopeLock Lock(&m_Mutex);
+	OutStats.SourceViewCount = m_Subscribers.Num();
+}
+
+void FInVideoSource::FanOut()
+{
+	bool bPopped = false;
+	for (;;)
+	{
+		if (!m_bHasHeldFrame)
+		{
+			if (!m_Ring.Pop(m_HeldFrame))
+			{
+				break;
+			}
+			m_bHasHeldFrame = true;
+			bPopped = true;
+		}
+		if (!DeliverHeldFrame())
+		{
+			break;
+		}
+		m_bHasHeldFrame = false;
+	}
+	if (bPopped)
+	{
+		// 解码输出队列腾出了空位
+		m_Decoder->Wake();
+	}
+}
+
+bool FInVideoSource::DeliverHeldFrame()
+{
+	// 任何一个活跃订阅者的队列满（Block 策略）就整体等待，由该订阅者取帧后再分发
+	bool bAnyActive = false;
+	for (const TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		if (IsActive(*Entry))
+		{
+			bAnyActive = true;
+			if (!Entry->Subscriber.Ring->CanPush())
+			{
+				return false;
+			}
+		}
+	}
+	if (!bAnyActive)
+	{
+		// 全部暂停时解码器也已暂停，保留这一帧给恢复后的订阅者
+		return false;
+	}
+
+	++m_FrameSerial;
+	// 先分发需要拷贝的订阅者，最后一个原始尺寸的订阅者直接交换，只有一个订阅者时没有额外拷贝
+	FSubscriberEntry* SwapTarget = nullptr;
+	for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		if (!IsActive(*Entry))
+		{
+			continue;
+		}
+		TrackFirstPlay(*Entry);
+		const FIntPoint Size = GetTargetSize(*Entry);
+		if (Size != FIntPoint::ZeroValue)
+		{
+			CopyToSubscriber(*Entry, GetScaledImage(Size));
+			continue;
+		}
+		if (SwapTarget != nullptr)
+		{
+			CopyToSubscriber(*SwapTarget, m_HeldFrame.Image);
+		}
+		SwapTarget = Entry.Get();
+	}
+	if (SwapTarget != nullptr)
+	{
+		SwapTarget->Subscriber.Ring->TryPush(m_HeldFrame);
+		if (SwapTarget->Subscriber.OnFramePushed)
+		{
+			SwapTarget->Subscriber.OnFramePushed();
+		}
+	}
+	return true;
+}
+
+bool FInVideoSource::IsActive(const FSubscriberEntry& Entry) const
+{
+	return !Entry.Subscriber.bPaused && Entry.Subscriber.Throttle != EInVideoDecodeThrottle::Suspend && Entry.Subscriber.Ring != nullptr;
+}
+
+FIntPoint FInVideoSource::GetTargetSize(const FSubscriberEntry& Entry) const
+{
+	const FIntPoint FrameSize(m_HeldFrame.Image.cols, m_HeldFrame.Image.rows);
+	FIntPoint Size = Entry.Subscriber.OutputSize;
+	if (Entry.Subscriber.bShrinkOnly)
+	{
+		Size = Size.ComponentMin(FrameSize);
+	}
+	const bool bScalable = m_HeldFrame.Layout == EInVideoPlaneLayout::PackedBGR;
+	if (!bScalable || Size == FIntPoint::ZeroValue || Size == FrameSize)
+	{
+		return FIntPoint::ZeroValue;
+	}
+	return Size;
+}
+
+const cv::Mat& FInVideoSource::GetScaledImage(FIntPoint Size)
+{
+	TUniquePtr<FScaledImage>* Found = m_ScaledImages.FindByPredicate([Size](const TUniquePtr<FScaledImage>& Scaled) { return Scaled->Size == Size; });
+	FScaledImage& Scaled = Found != nullptr ? **Found : *m_ScaledImages.Add_GetRef(MakeUnique<FScaledImage>());
+	if (Scaled.Size != Size || Scaled.Serial != m_FrameSerial)
+	{
+		// 同一尺寸每帧只缩放一次，目标 Mat 跨帧复用；缩小用面积插值，避免缩略图混叠
+		const bool bShrink = Size.X <= m_HeldFrame.Image.cols && Size.Y <= m_HeldFrame.Image.rows;
+		cv::resize(m_HeldFrame.Image, Scaled.Image, cv::Size(Size.X, Size.Y), 0, 0, bShrink ? cv::INTER_AREA : cv::INTER_LINEAR);
+		Scaled.Size = Size;
+		Scaled.Serial = m_FrameSerial;
+	}
+	return Scaled.Image;
+}
+
+void FInVideoSource::CopyToSubscriber(FSubscriberEntry& Entry, const cv::Mat& Image)
+{
+	FInVideoFrame& Staging = Entry.Staging;
+	Image.copyTo(Staging.Image);
+	Staging.FrameIndex = m_HeldFrame.FrameIndex;
+	Staging.PtsMs = m_HeldFrame.PtsMs;
+	Staging.CaptureEpochMs = m_HeldFrame.CaptureEpochMs;
+	Staging.DecodedSeconds = m_HeldFrame.DecodedSeconds;
+	Staging.Layout = m_HeldFrame.Layout;
+	const bool bScaled = Image.data != m_HeldFrame.Image.data;
+	Staging.Width = bScaled ? Image.cols : m_HeldFrame.Width;
+	Staging.Height = bScaled ? Image.rows : m_HeldFrame.Height;
+	Entry.Subscriber.Ring->TryPush(Staging);
+	if (Entry.Subscriber.OnFramePushed)
+	{
+		Entry.Subscriber.OnFramePushed();
+	}
+}
+
+void FInVideoSource::TrackFirstPlay(FSubscriberEntry& Entry)
+{
+	if (Entry.bFirstPlayCompleted || m_bReverse)
+	{
+		return;
+	}
+	const int32 FrameIndex = m_HeldFrame.FrameIndex;
+	const int32 LastFrame = Entry.LastFrame;
+	Entry.LastFrame = FrameIndex;
+	if (Entry.JoinFrame == INDEX_NONE)
+	{
+		Entry.JoinFrame = FrameIndex;
+		return;
+	}
+	// 从第 0 帧开始的订阅者由 HandleReachedEnd 在到达末尾时完成
+	if (Entry.JoinFrame == 0)
+	{
+		return;
+	}
+	Entry.bWrapped |= LastFrame != INDEX_NONE && FrameIndex < LastFrame;
+	// 回绕后播放到加入帧的前一帧，加入以来的每一帧都已交出过
+	if (Entry.bWrapped && FrameIndex + 1 >= Entry.JoinFrame)
+	{
+		CompleteFirstPlay(Entry);
+	}
+}
+
+void FInVideoSource::CompleteFirstPlay(FSubscriberEntry& Entry)
+{
+	Entry.bFirstPlayCompleted = true;
+	UE_LOG(LogTemp, Log, TEXT("FInVideoSource 订阅者 %d 首播完成 (自第 %d 帧起) url=%s"), Entry.Id, Entry.JoinFrame, *m_VideoURL);
+	if (Entry.Subscriber.OnFirstPlayCompleted)
+	{
+		Entry.Subscriber.OnFirstPlayCompleted();
+	}
+}
+
+void FInVideoSource::PruneScaledImages()
+{
+	m_ScaledImages.RemoveAll([this](const TUniquePtr<FScaledImage>& Scaled)
+		{
+			return !m_Subscribers.ContainsByPredicate([&Scaled](const TUniquePtr<FSubscriberEntry>& Entry)
+				{
+					return Entry->Subscriber.OutputSize == Scaled->Size;
+				});
+		});
+}
+
+void FInVideoSource::UpdateDecoderPaused()
+{
+	const bool bAllPaused = m_Subscribers.Num() > 0
+		&& !m_Subscribers.ContainsByPredicate([](const TUniquePtr<FSubscriberEntry>& Entry) { return !Entry->Subscriber.bPaused; });
+	m_Decoder->SetPaused(bAllPaused);
+}
+
+void FInVideoSource::UpdateDecoderOutputSize()
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+	for (const TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		const FIntPoint& Requested = Entry->Subscriber.OutputSize;
+		if (Requested == FIntPoint::ZeroValue)
+		{
+			// 有订阅者要原始尺寸，解码器不缩放
+			Size = FIntPoint::ZeroValue;
+			break;
+		}
+		Size = Size.ComponentMax(Requested);
+	}
+	m_Decoder->SetOutputSize(Size);
+}
+
+void FInVideoSource::UpdateDecoderThrottle()
+{
+	EInVideoDecodeThrottle Throttle = EInVideoDecodeThrottle::Suspend;
+	float MaxFps = 0.0f;
+	for (const TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		Throttle = FMath::Min(Throttle, Entry->Subscriber.Throttle);
+		MaxFps = FMath::Max(MaxFps, Entry->Subscriber.ThrottleFps);
+	}
+	m_Decoder->SetThrottle(m_Subscribers.Num() > 0 ? Throttle : EInVideoDecodeThrottle::None, MaxFps);
+}
+
+FInVideoSource::FSubscriberEntry* FInVideoSource::FindSubscriber(int32 SubscriberId)
+{
+	TUniquePtr<FSubscriberEntry>* Found = m_Subscribers.FindByPredicate([SubscriberId](const TUniquePtr<FSubscriberEntry>& Entry) { return Entry->Id == SubscriberId; });
+	return Found != nullptr ? Found->Get() : nullptr;
+}
+
+void FInVideoSource::HandleSeekApplied()
+{
+	// 解码器已清空输出队列，Seek 之前的帧不再分发
+	FScopeLock Lock(&m_Mutex);
+	m_bHasHeldFrame = false;
+	for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		// Seek 之后不再按加入点计算，下一次到达末尾时完成，与独占源一致
+		if (!Entry->bFirstPlayCompleted)
+		{
+			Entry->JoinFrame = 0;
+			Entry->LastFrame = INDEX_NONE;
+			Entry->bWrapped = false;
+		}
+		Entry->Subscriber.Ring->Clear();
+		if (Entry->Subscriber.OnSeekApplied)
+		{
+			Entry->Subscriber.OnSeekApplied();
+		}
+	}
+}
+
+void FInVideoSource::HandleReachedEnd()
+{
+	FScopeLock Lock(&m_Mutex);
+	for (TUniquePtr<FSubscriberEntry>& Entry : m_Subscribers)
+	{
+		// 从第 0 帧开始的订阅者到达末尾即完成；中途加入的由 TrackFirstPlay 在回绕后播放到加入点时完成
+		if (!Entry->bFirstPlayCompleted && Entry->JoinFrame == 0)
+		{
+			CompleteFirstPlay(*Entry);
+		}
+	}
+}
@@ -0,0 +1,396 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoSurface.h"
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "HAL/IConsoleManager.h"
+#include "TextureResource.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	TAutoConsoleVariable<int32> CVarInVideoTexturePoolMaxFree(
+		TEXT("InVideo.TexturePool.MaxFree"),
+		8,
+		TEXT("InVideo 纹理池保留的空闲纹理数，超出的在冷却后立即释放渲染资源"),
+		ECVF_Default);
+
+	// 单级 mip 纹理的尺寸档位粒度
+	constexpr int32 SizeGranularity = 64;
+	// 归还后至少经过的游戏帧数才复用或释放：旧纹理的上传命令已提交、Brush 已切到新纹理
+	constexpr uint64 ReuseDelayFrames = 3;
+
+	TUniquePtr<FInVideoTexturePool> GTexturePool;
+	FTSTicker::FDelegateHandle GTrimTicker;
+
+	void TrimTexturePool()
+	{
+		FInVideoTexturePool::Get().Trim(CVarInVideoTexturePoolMaxFree.GetValueOnGameThread());
+	}
+
+	FAutoConsoleCommand TexturePoolStatsCommand(
+		TEXT("InVideo.TexturePool.Stats"),
+		TEXT("输出视频纹理池的使用情况"),
+		FConsoleCommandDelegate::CreateLambda([]() { FInVideoTexturePool::Get().LogStats(); }));
+
+	FAutoConsoleCommand TexturePoolTrimCommand(
+		TEXT("InVideo.TexturePool.Trim"),
+		TEXT("释放视频纹理池中所有冷却完毕的空闲纹理"),
+		FConsoleCommandDelegate::CreateLambda([]() { FInVideoTexturePool::Get().Trim(0); }));
+}
+
+FInVideoTexturePool& FInVideoTexturePool::Get()
+{
+	check(IsInGameThread());
+	if (!GTexturePool.IsValid())
+	{
+		GTexturePool.Reset(new FInVideoTexturePool());
+	}
+	return *GTexturePool;
+}
+
+void FInVideoTexturePool::Shutdown()
+{
+	if (GTrimTicker.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(GTrimTicker);
+		GTrimTicker.Reset();
+	}
+	// 引擎退出时渲染资源由纹理自身释放，这里只放开引用
+	GTexturePool.Reset();
+}
+
+FIntPoint FInVideoTexturePool::GetSizeClass(EInVideoSurfaceKind Kind, FIntPoint Size, int32 NumMips)
+{
+	if (Kind != EInVideoSurfaceKind::Texture || NumMips > 1)
+	{
+		return Size;
+	}
+	return FIntPoint(
+		FMath::DivideAndRoundUp(Size.X, SizeGranularity) * SizeGranularity,
+		FMath::DivideAndRoundUp(Size.Y, SizeGranularity) * SizeGranularity);
+}
+
+bool FInVideoTexturePool::IsCooledDown(const FEntry& Entry) const
+{
+	return GFrameCounter >= Entry.ReleasedFrame + ReuseDelayFrames;
+}
+
+UTexture* FInVideoTexturePool::Acquire(EInVideoSurfaceKind Kind, FIntPoint SizeClass, int32 NumMips)
+{
+	check(IsInGameThread());
+	for (int32 i = 0; i < m_Free.Num(); ++i)
+	{
+		FEntry& Entry = m_Free[i];
+		if (Entry.Kind == Kind && Entry.SizeClass == SizeClass && Entry.NumMips == NumMips && IsCooledDown(Entry))
+		{
+			UTexture* Texture = Entry.Texture;
+			m_InUse.Add(MoveTemp(Entry));
+			m_Free.RemoveAt(i);
+			++m_Reused;
+			return Texture;
+		}
+	}
+
+	UTexture* Texture = CreateTexture(Kind, SizeClass, NumMips);
+	if (nullptr == Texture)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FInVideoTexturePool 创建纹理失败 %dx%d mips=%d"), SizeClass.X, SizeClass.Y, NumMips);
+		return nullptr;
+	}
+	FEntry Entry;
+	Entry.Texture = Texture;
+	Entry.Kind = Kind;
+	Entry.SizeClass = SizeClass;
+	Entry.NumMips = NumMips;
+	m_InUse.Add(MoveTemp(Entry));
+	++m_Created;
+	return Texture;
+}
+
+void FInVideoTexturePool::Release(UTexture* Texture)
+{
+	check(IsInGameThread());
+	const int32 Index = m_InUse.IndexOfByPredicate([Texture](const FEntry& Entry) { return Entry.Texture == Texture; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+	FEntry Entry = MoveTemp(m_InUse[Index]);
+	m_InUse.RemoveAtSwap(Index);
+	Entry.ReleasedFrame = GFrameCounter;
+	m_Free.Add(MoveTemp(Entry));
+
+	// 超出上限的部分等冷却后释放
+	if (m_Free.Num() > CVarInVideoTexturePoolMaxFree.GetValueOnGameThread() && !GTrimTicker.IsValid())
+	{
+		GTrimTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float)
+			{
+				TrimTexturePool();
+				const bool bOverBudget = GTexturePool.IsValid()
+					&& GTexturePool->m_Free.Num() > CVarInVideoTexturePoolMaxFree.GetValueOnGameThread();
+				if (!bOverBudget)
+				{
+					GTrimTicker.Reset();
+				}
+				return bOverBudget;
+			}));
+	}
+}
+
+void FInVideoTexturePool::Trim(int32 MaxFree)
+{
+	check(IsInGameThread());
+	MaxFree = FMath::Max(0, MaxFree);
+	// 最早归还的先释放
+	for (int32 i = 0; i < m_Free.Num() && m_Free.Num() > MaxFree;)
+	{
+		if (!IsCooledDown(m_Free[i]))
+		{
+			++i;
+			continue;
+		}
+		DestroyTexture(m_Free[i].Texture);
+		m_Free.RemoveAt(i);
+		++m_Destroyed;
+	}
+}
+
+void FInVideoTexturePool::LogStats() const
+{
+	int64 FreeBytes = 0;
+	for (const FEntry& Entry : m_Free)
+	{
+		FreeBytes += (int64)Entry.SizeClass.X * Entry.SizeClass.Y * 4;
+	}
+	UE_LOG(LogTemp, Log, TEXT("InVideo.TexturePool 使用中 %d 空闲 %d (mip0 约 %.1f MB) 新建 %d 复用 %d 释放 %d"),
+		m_InUse.Num(), m_Free.Num(), FreeBytes / (1024.0 * 1024.0), m_Created, m_Reused, m_Destroyed);
+}
+
+void FInVideoTexturePool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (FEntry& Entry : m_InUse)
+	{
+		Collector.AddReferencedObject(Entry.Texture);
+	}
+	for (FEntry& Entry : m_Free)
+	{
+		Collector.AddReferencedObject(Entry.Texture);
+	}
+}
+
+FString FInVideoTexturePool::GetReferencerName() const
+{
+	return TEXT("FInVideoTexturePool");
+}
+
+UTexture* FInVideoTexturePool::CreateTexture(EInVideoSurfaceKind Kind, FIntPoint SizeClass, int32 NumMips) const
+{
+	if (Kind == EInVideoSurfaceKind::RenderTarget)
+	{
+		UTextureRenderTarget2D* Target = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+		Target->RenderTargetFormat = RTF_RGBA8_SRGB;
+		Target->ClearColor = FLinearColor::Black;
+		Target->InitAutoFormat(SizeClass.X, SizeClass.Y);
+		Target->UpdateResourceImmediate(true);
+		return Target;
+	}
+
+	UTexture2D* Texture = UTexture2D::CreateTransient(SizeClass.X, SizeClass.Y);
+	if (nullptr == Texture)
+	{
+		return nullptr;
+	}
+	// CreateTransient 只有第 0 级，补齐其余 mip，内容由每帧上传填充
+	for (int32 MipIndex = 1; MipIndex < NumMips; ++MipIndex)
+	{
+		FTexture2DMipMap* Mip = new FTexture2DMipMap();
+		Texture->GetPlatformData()->Mips.Add(Mip);
+		Mip->SizeX = FMath::Max(1, SizeClass.X >> MipIndex);
+		Mip->SizeY = FMath::Max(1, SizeClass.Y >> MipIndex);
+		const int64 MipBytes = (int64)Mip->SizeX * Mip->SizeY * 4;
+		Mip->BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memzero(Mip->BulkData.Realloc(MipBytes), MipBytes);
+		Mip->BulkData.Unlock();
+	}
+	Texture->Filter = NumMips > 1 ? TF_Trilinear : TF_Bilinear;
+	Texture->NeverStream = true;
+	Texture->SRGB = true;
+	Texture->CompressionSettings = TC_Default;
+	Texture->UpdateResource();
+	return Texture;
+}
+
+void FInVideoTexturePool::DestroyTexture(UTexture* Texture)
+{
+	if (nullptr == Texture)
+	{
+		return;
+	}
+	// 渲染资源的释放命令排在之前所有上传命令之后；UObject 在下一次 GC 时回收
+	Texture->ReleaseResource();
+	Texture->MarkAsGarbage();
+}
+
+FBox2f FInVideoSurface::FView::GetUVRegion(FIntPoint FrameSize) const
+{
+	if (TextureSize.X <= 0 || TextureSize.Y <= 0)
+	{
+		return FBox2f(FVector2f::ZeroVector, FVector2f(1.0f, 1.0f));
+	}
+	const float MaxU = FrameSize.X < TextureSize.X ? (FrameSize.X - 0.5f) / TextureSize.X : 1.0f;
+	const float MaxV = FrameSize.Y < TextureSize.Y ? (FrameSize.Y - 0.5f) / TextureSize.Y : 1.0f;
+	return FBox2f(FVector2f::ZeroVector, FVector2f(MaxU, MaxV));
+}
+
+FInVideoSurface::FInVideoSurface(EInVideoSurfaceKind Kind)
+	: m_Kind(Kind)
+{
+}
+
+FInVideoSurface::~FInVideoSurface()
+{
+	Release();
+}
+
+FInVideoSurface::FView FInVideoSurface::Resolve(FIntPoint FrameSize, int32 NumMips)
+{
+	if (FrameSize.X <= 0 || FrameSize.Y <= 0)
+	{
+		return FView();
+	}
+	const FIntPoint SizeClass = FInVideoTexturePool::GetSizeClass(m_Kind, FrameSize, NumMips);
+	UTexture* Retired[2] = { nullptr, nullptr };
+	FView Result;
+	uint32 RequestId = 0;
+	bool bRequest = false;
+	{
+		FScopeLock Lock(&m_Mutex);
+		if (m_Ready.View.Texture != nullptr)
+		{
+			if (m_Ready.SizeClass == SizeClass && m_Ready.View.NumMips == NumMips)
+			{
+				// 换上新纹理，旧纹理之后不再被显示线程使用
+				Retired[0] = m_Current.View.Texture;
+				m_Current = m_Ready;
+			}
+			else
+			{
+				// 申请期间尺寸又变了
+				Retired[0] = m_Ready.View.Texture;
+			}
+			m_Ready = FSlot();
+		}
+		if (m_Current.View.IsValid() && m_Current.SizeClass == SizeClass && m_Current.View.NumMips == NumMips)
+		{
+			Result = m_Current.View;
+		}
+		else if (!m_bRequestPending || m_RequestedClass != SizeClass || m_RequestedMips != NumMips)
+		{
+			m_bRequestPending = true;
+			m_RequestedClass = SizeClass;
+			m_RequestedMips = NumMips;
+			RequestId = ++m_RequestId;
+			bRequest = true;
+		}
+	}
+	for (UTexture* Texture : Retired)
+	{
+		ReleaseToPool(Texture);
+	}
+
+	if (bRequest)
+	{
+		AsyncTask(ENamedThreads::GameThread, [WeakThis = TWeakPtr<FInVideoSurface, ESPMode::ThreadSafe>(AsShared()),
+			Kind = m_Kind, SizeClass, NumMips, RequestId]()
+			{
+				UTexture* Texture = FInVideoTexturePool::Get().Acquire(Kind, SizeClass, NumMips);
+				TSharedPtr<FInVideoSurface, ESPMode::ThreadSafe> Surface = WeakThis.Pin();
+				if (Surface.IsValid())
+				{
+					Surface->OnAcquired(Texture, SizeClass, NumMips, RequestId);
+				}
+				else
+				{
+					FInVideoTexturePool::Get().Release(Texture);
+				}
+			});
+	}
+	return Result;
+}
+
+void FInVideoSurface::OnAcquired(UTexture* Texture, FIntPoint SizeClass, int32 NumMips, uint32 RequestId)
+{
+	check(IsInGameThread());
+	if (nullptr == Texture)
+	{
+		FScopeLock Lock(&m_Mutex);
+		if (RequestId == m_RequestId)
+		{
+			// 允许下一次 Resolve 重试
+			m_bRequestPending = false;
+		}
+		return;
+	}
+
+	UTexture* Stale = nullptr;
+	{
+		FScopeLock Lock(&m_Mutex);
+		if (RequestId != m_RequestId)
+		{
+			Stale = Texture;
+		}
+		else
+		{
+			m_bRequestPending = false;
+			Stale = m_Ready.View.Texture;
+			m_Ready.SizeClass = SizeClass;
+			m_Ready.View.Texture = Texture;
+			m_Ready.View.TextureSize = SizeClass;
+			m_Ready.View.NumMips = NumMips;
+			m_Ready.View.Resource = m_Kind == EInVideoSurfaceKind::RenderTarget
+				? static_cast<UTextureRenderTarget2D*>(Texture)->GameThread_GetRenderTargetResource()
+				: Texture->GetResource();
+		}
+	}
+	ReleaseToPool(Stale);
+}
+
+void FInVideoSurface::Release()
+{
+	UTexture* Textures[2] = { nullptr, nullptr };
+	{
+		FScopeLock Lock(&m_Mutex);
+		Textures[0] = m_Current.View.Texture;
+		Textures[1] = m_Ready.View.Texture;
+		m_Current = FSlot();
+		m_Ready = FSlot();
+		m_bRequestPending = false;
+		++m_RequestId;
+	}
+	for (UTexture* Texture : Textures)
+	{
+		ReleaseToPool(Texture);
+	}
+}
+
+void FInVideoSurface::ReleaseToPool(UTexture* Texture)
+{
+	if (nullptr == Texture)
+	{
+		return;
+	}
+	if (IsInGameThread())
+	{
+		FInVideoTexturePool::Get().Release(Texture);
+		return;
+	}
+	// 池只在游戏线程访问，纹理在归还前一直由池引用，不会被 GC
+	AsyncTask(ENamedThreads::GameThread, [Texture]()
+		{
+			FInVideoTexturePool::Get().Release(Texture);
+		});
+}
@@ -0,0 +1,391 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoSyncGroup.h"
+#include "Async/Async.h"
+#include "UObject/Package.h"
+#include "RenderingThread.h"
+
+namespace
+{
+	// waitAny 单次最长等待，期间没有流就绪时返回，保证停止请求能及时响应
+	constexpr int64 WaitAnyTimeoutNs = 20 * 1000 * 1000;
+	// 所有流都读取失败时的重试间隔
+	constexpr double FailedGrabRetrySeconds = 0.005;
+	// 依次 grab 时连续这么多轮所有流都失败，判定整组失败
+	constexpr int32 MaxFailedGrabRounds = 3;
+	// waitAny 连续这么久没有任何流就绪，判定整组失败
+	constexpr double MaxNoFrameSeconds = 10.0;
+	constexpr int32 NetworkOpenTimeoutMs = 5000;
+	constexpr int32 NetworkReadTimeoutMs = 3000;
+}
+
+FInVideoSyncGroup::FInVideoSyncGroup(TArray<FMember> Members, float ToleranceMs, FDelegatePlayFailed Failed)
+	: m_ToleranceMs(FMath::Max(0.0f, ToleranceMs))
+	, m_Failed(Failed)
+{
+	for (const FMember& Member : Members)
+	{
+		TUniquePtr<FStream>& Stream = m_Streams.Add_GetRef(MakeUnique<FStream>());
+		Stream->VideoURL = Member.VideoURL;
+		Stream->Player = MakeUnique<VideoPlay>();
+		Stream->Player->SetUploadBufferCount(Member.UploadBufferCount);
+		Stream->Player->StartSyncMember(Member.VideoURL, Member.Widget.Get());
+	}
+	m_Captures.resize(m_Streams.Num());
+}
+
+FInVideoSyncGroup::~FInVideoSyncGroup()
+{
+	m_Stopping = true;
+	if (m_Task.IsValid())
+	{
+		// 等待正在执行的 grab 返回，网络流最长为读取超时
+		FInVideoWorkerPool::Get().Unregister(m_Task);
+		m_Task.Reset();
+	}
+	for (TUniquePtr<FStream>& Stream : m_Streams)
+	{
+		Stream->Player->StopPlay();
+	}
+	for (cv::VideoCapture& Capture : m_Captures)
+	{
+		Capture.release();
+	}
+	UE_LOG(LogTemp, Log, TEXT("FInVideoSyncGroup 停止, 共显示 %d 组, 未对齐 %d 组"), m_FrameSets, m_MisalignedSets);
+}
+
+void FInVideoSyncGroup::Start()
+{
+	m_Stopping = false;
+	// open/waitAny/grab 都会阻塞，整组作为一个任务在 I/O 线程组上运行
+	m_Task = FInVideoWorkerPool::Get().RegisterBlocking(FString::Printf(TEXT("SyncGroup x%d"), m_Streams.Num()),
+		[this](double NowSeconds) { return Tick(NowSeconds); });
+}
+
+double FInVideoSyncGroup::Tick(double NowSeconds)
+{
+	if (m_Stopping)
+	{
+		return -1.0;
+	}
+	if (!m_bOpened)
+	{
+		if (!OpenStreams())
+		{
+			NotifyFailed();
+			return -1.0;
+		}
+		m_bOpened = true;
+		m_LastFrameSeconds = FPlatformTime::Seconds();
+	}
+
+	// waitAny 和 grab 本身会等待新帧，不需要额外的调度间隔
+	if (GrabReady() == 0)
+	{
+		if (RecordEmptyRound(FPlatformTime::Seconds()))
+		{
+			NotifyFailed();
+			return -1.0;
+		}
+		return FPlatformTime::Seconds() + FailedGrabRetrySeconds;
+	}
+	m_FailedRounds = 0;
+	m_LastFrameSeconds = FPlatformTime::Seconds();
+	TryPublish();
+	return FPlatformTime::Seconds();
+}
+
+bool FInVideoSyncGroup::RecordEmptyRound(double NowSeconds)
+{
+	if (m_Stopping)
+	{
+		return false;
+	}
+	if (m_bUseWaitAny)
+	{
+		// waitAny 超时只说明这段时间没有新帧
+		if (NowSeconds - m_LastFrameSeconds < MaxNoFrameSeconds)
+		{
+			return false;
+		}
+		UE_LOG(LogTemp, Error, TEXT("FInVideoSyncGroup %.1f 秒没有任何流就绪, 停止同步组"), NowSeconds - m_LastFrameSeconds);
+		return true;
+	}
+	// 网络流每次失败的 grab 已经等待了读取超时
+	if (++m_FailedRounds < MaxFailedGrabRounds)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FInVideoSyncGroup 所有流读取失败 (%d/%d)"), m_FailedRounds, MaxFailedGrabRounds);
+		return false;
+	}
+	UE_LOG(LogTemp, Error, TEXT("FInVideoSyncGroup 连续 %d 轮所有流读取失败, 停止同步组"), m_FailedRounds);
+	return true;
+}
+
+bool FInVideoSyncGroup::OpenStreams()
+{
+	bool bAllV4L2 = true;
+	bool bAllAbsolute = true;
+	for (int32 Index = 0; Index < m_Streams.Num(); ++Index)
+	{
+		if (!OpenStream(Index))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FInVideoSyncGroup 打开失败 url=%s"), *m_Streams[Index]->VideoURL);
+			return false;
+		}
+		bAllV4L2 &= m_Captures[Index].getBackendName() == "V4L2";
+		bAllAbsolute &= m_Streams[Index]->OpenTimeUs > 0.0;
+	}
+
+	// OpenCV 4.6 的 waitAny 只实现了 V4L2 后端，且要求所有流使用同一后端
+	m_bUseWaitAny = bAllV4L2;
+	// 所有流都提供绝对时间时按采集时刻对齐，否则按本机到达时刻
+	m_bAbsoluteTime = bAllAbsolute;
+	UE_LOG(LogTemp, Log, TEXT("FInVideoSyncGroup 打开 %d 路流, %s, 时间戳: %s"), m_Streams.Num(),
+		m_bUseWaitAny ? TEXT("使用 waitAny") : TEXT("后端不支持 waitAny, 依次 grab"),
+		m_bAbsoluteTime ? TEXT("源绝对时间") : TEXT("本机到达时间"));
+	return true;
+}
+
+bool FInVideoSyncGroup::OpenStream(int32 Index)
+{
+	FStream& Stream = *m_Streams[Index];
+	cv::VideoCapture& Capture = m_Captures[Index];
+	bool bOpened = false;
+	if (Stream.VideoURL.IsNumeric())
+	{
+		// 本机摄像头序号，Linux 上默认走 V4L2
+		bOpened = Capture.open(FCString::Atoi(*Stream.VideoURL), cv::CAP_ANY);
+	}
+	else if (FInVideoDecoder::IsNetworkURL(Stream.VideoURL))
+	{
+		// 与解码器一致：打开和读取都带超时，断流时 grab 返回失败而不是一直阻塞整个组
+		const std::vector<int> Params = {
+			cv::CAP_PROP_OPEN_TIMEOUT_MSEC, NetworkOpenTimeoutMs,
+			cv::CAP_PROP_READ_TIMEOUT_MSEC, NetworkReadTimeoutMs };
+		bOpened = Capture.open(TCHAR_TO_UTF8(*Stream.VideoURL), cv::CAP_FFMPEG, Params);
+		if (bOpened)
+		{
+			Capture.set(cv::CAP_PROP_BUFFERSIZE, 1);
+		}
+	}
+	else
+	{
+		bOpened = Capture.open(TCHAR_TO_UTF8(*Stream.VideoURL));
+	}
+	if (bOpened)
+	{
+		Stream.OpenTimeUs = Capture.get(cv::CAP_PROP_STREAM_OPEN_TIME_USEC);
+	}
+	return bOpened;
+}
+
+int32 FInVideoSyncGroup::GrabReady()
+{
+	std::vector<int> ReadyIndex;
+	if (m_bUseWaitAny)
+	{
+		// 同时等待所有流，返回时已就绪的流已经 grab 完成
+		if (!cv::VideoCapture::waitAny(m_Captures, ReadyIndex, WaitAnyTimeoutNs))
+		{
+			ReadyIndex.clear();
+		}
+	}
+	else
+	{
+		for (int32 Index = 0; Index < (int32)m_Captures.size() && false == m_Stopping; ++Index)
+		{
+			if (m_Captures[Index].grab())
+			{
+				ReadyIndex.push_back(Index);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Verbose, TEXT("FInVideoSyncGroup grab 失败 url=%s"), *m_Streams[Index]->VideoURL);
+			}
+		}
+	}
+	for (const int Index : ReadyIndex)
+	{
+		Retrieve(Index);
+	}
+	return (int32)ReadyIndex.size();
+}
+
+void FInVideoSyncGroup::Retrieve(int32 Index)
+{
+	FStream& Stream = *m_Streams[Index];
+	cv::VideoCapture& Capture = m_Captures[Index];
+	if (Stream.Count == MaxHistoryFrames)
+	{
+		// 其他流迟迟没有新帧，丢弃本路最旧的帧
+		Stream.Head = (Stream.Head + 1) % MaxHistoryFrames;
+		--Stream.Count;
+		FScopeLock Lock(&m_StatsMutex);
+		++m_SkippedFrames;
+	}
+	const int32 Slot = (Stream.Head + Stream.Count) % MaxHistoryFrames;
+	FInVideoFrame& Frame = Stream.Frames[Slot];
+	if (!Capture.retrieve(Frame.Image) || Frame.Image.type() != CV_8UC3)
+	{
+		return;
+	}
+	Frame.FrameIndex = Stream.NextFrameIndex++;
+	Frame.PtsMs = Capture.get(cv::CAP_PROP_POS_MSEC);
+	Frame.CaptureEpochMs = Stream.OpenTimeUs > 0.0 ? Stream.OpenTimeUs / 1000.0 + Frame.PtsMs : -1.0;
+	Frame.DecodedSeconds = FPlatformTime::Seconds();
+	Frame.Layout = EInVideoPlaneLayout::PackedBGR;
+	Frame.Width = Frame.Image.cols;
+	Frame.Height = Frame.Image.rows;
+	Stream.TimesMs[Slot] = m_bAbsoluteTime ? Frame.CaptureEpochMs : Frame.DecodedSeconds * 1000.0;
+	++Stream.Count;
+}
+
+void FInVideoSyncGroup::TryPublish()
+{
+	// 参考时刻：各路最新帧中最早的一个，即最慢的那一路
+	double ReferenceMs = TNumericLimits<double>::Max();
+	for (const TUniquePtr<FStream>& Stream : m_Streams)
+	{
+		if (Stream->Count == 0)
+		{
+			return;
+		}
+		ReferenceMs = FMath::Min(ReferenceMs, Stream->TimesMs[(Stream->Head + Stream->Count - 1) % MaxHistoryFrames]);
+	}
+	if (ReferenceMs <= m_LastReferenceMs)
+	{
+		// 最慢的一路还没有新帧
+		return;
+	}
+
+	// 每路取最接近参考时刻的帧，更早的帧跳过
+	TArray<int32, TInlineAllocator<16>> Picked;
+	double MinMs = TNumericLimits<double>::Max();
+	double MaxMs = -TNumericLimits<double>::Max();
+	for (const TUniquePtr<FStream>& Stream : m_Streams)
+	{
+		int32 Best = 0;
+		for (int32 i = 1; i < Stream->Count; ++i)
+		{
+			const double Time = Stream->TimesMs[(Stream->Head + i) % MaxHistoryFrames];
+			const double BestTime = Stream->TimesMs[(Stream->Head + Best) % MaxHistoryFrames];
+			if (FMath::Abs(Time - ReferenceMs) < FMath::Abs(BestTime - ReferenceMs))
+			{
+				Best = i;
+			}
+		}
+		const double Time = Stream->TimesMs[(Stream->Head + Best) % MaxHistoryFrames];
+		MinMs = FMath::Min(MinMs, Time);
+		MaxMs = FMath::Max(MaxMs, Time);
+		Picked.Add(Best);
+	}
+
+	// 整组在同一个任务里准备纹理数据，整批交给上传调度，在同一帧的渲染命令中执行
+	int32 Skipped = 0;
+	for (int32 Index = 0; Index < m_Streams.Num(); ++Index)
+	{
+		FStream& Stream = *m_Streams[Index];
+		const int32 Slot = (Stream.Head + Picked[Index]) % MaxHistoryFrames;
+		Stream.Player->PresentSyncedFrame(Stream.Frames[Slot], m_RenderBatch);
+		Skipped += Picked[Index];
+		Stream.Head = (Slot + 1) % MaxHistoryFrames;
+		Stream.Count -= Picked[Index] + 1;
+	}
+	int32 Superseded = 0;
+	if (m_RenderBatch.Num() > 0)
+	{
+		Superseded = FInVideoUploadScheduler::Get().Submit(m_RenderBatch);
+	}
+	m_LastReferenceMs = ReferenceMs;
+
+	const float SpreadMs = (float)(MaxMs - MinMs);
+	FScopeLock Lock(&m_StatsMutex);
+	++m_FrameSets;
+	m_SkippedFrames += Skipped;
+	m_SupersededUploads += Superseded;
+	m_LastSpreadMs = SpreadMs;
+	m_MaxSpreadMs = FMath::Max(m_MaxSpreadMs, SpreadMs);
+	if (SpreadMs > m_ToleranceMs)
+	{
+		++m_MisalignedSets;
+	}
+}
+
+void FInVideoSyncGroup::NotifyFailed()
+{
+	AsyncTask(ENamedThreads::GameThread, [Failed = m_Failed]()
+		{
+			if (Failed.IsBound())
+				Failed.Execute();
+		});
+}
+
+FInVideoSyncGroupStats FInVideoSyncGroup::GetStats() const
+{
+	FInVideoSyncGroupStats Stats;
+	Stats.bUsingWaitAny = m_bOpened && m_bUseWaitAny;
+	Stats.bAbsoluteTimestamps = m_bAbsoluteTime;
+	FScopeLock Lock(&m_StatsMutex);
+	Stats.FrameSets = m_FrameSets;
+	Stats.MisalignedSets = m_MisalignedSets;
+	Stats.SkippedFrames = m_SkippedFrames;
+	Stats.SupersededUploads = m_SupersededUploads;
+	Stats.LastSpreadMs = m_LastSpreadMs;
+	Stats.MaxSpreadMs = m_MaxSpreadMs;
+	return Stats;
+}
+
+UInVideoSyncGroup* UInVideoSyncGroup::CreateSyncGroup()
+{
+	return NewObject<UInVideoSyncGroup>(GetTransientPackage());
+}
+
+void UInVideoSyncGroup::AddStream(UInVideoWidget* Widget, const FString& VideoURL)
+{
+	if (m_Group.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UInVideoSyncGroup 运行中不能添加流, 请先 StopGroup url=%s"), *VideoURL);
+		return;
+	}
+	FInVideoSyncGroup::FMember& Member = m_Members.AddDefaulted_GetRef();
+	Member.VideoURL = VideoURL;
+	Member.Widget = Widget;
+	Member.UploadBufferCount = IsValid(Widget) ? Widget->UploadBufferCount : 3;
+}
+
+void UInVideoSyncGroup::StartGroup(FDelegatePlayFailed Failed, float ToleranceMs)
+{
+	StopGroup();
+	if (m_Members.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UInVideoSyncGroup 没有添加任何流"));
+		return;
+	}
+	m_Group = MakeUnique<FInVideoSyncGroup>(m_Members, ToleranceMs, Failed);
+	m_Group->Start();
+}
+
+void UInVideoSyncGroup::StopGroup()
+{
+	if (!m_Group.IsValid())
+	{
+		return;
+	}
+	// 停止时要等待 grab 返回，不阻塞游戏线程
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Group = MoveTemp(m_Group)]() mutable
+		{
+			Group.Reset();
+		});
+}
+
+FInVideoSyncGroupStats UInVideoSyncGroup::GetGroupStats() const
+{
+	return m_Group.IsValid() ? m_Group->GetStats() : FInVideoSyncGroupStats();
+}
+
+void UInVideoSyncGroup::BeginDestroy()
+{
+	StopGroup();
+	Super::BeginDestroy();
+}
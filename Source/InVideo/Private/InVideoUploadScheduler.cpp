@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoUploadScheduler.h"
+#include "InVideoStats.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "Rendering/Texture2DResource.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+
+namespace
+{
+	TUniquePtr<FInVideoUploadScheduler> GScheduler;
+}
+
+void FInVideoUpload::Execute(FRHICommandListImmediate& RHICmdList) const
+{
+	if (!Buffer.IsValid())
+	{
+		return;
+	}
+	if (nullptr != Target)
+	{
+		if (Planes.IsValid())
+		{
+			Planes->UploadAndConvert(RHICmdList, Layout, Width, Height, Buffer->GetData(), Target);
+		}
+		return;
+	}
+	if (nullptr == Texture)
+	{
+		return;
+	}
+	const int32 CurrentFirstMip = Texture->GetCurrentFirstMip();
+	const uint8* MipData = Buffer->GetData();
+	for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+	{
+		const int32 MipWidth = FMath::Max(1, Width >> MipIndex);
+		const int32 MipHeight = FMath::Max(1, Height >> MipIndex);
+		if (MipIndex >= CurrentFirstMip)
+		{
+			// 纹理可能大于帧（尺寸档位），只更新左上角
+			RHIUpdateTexture2D(Texture->GetTexture2DRHI(), MipIndex - CurrentFirstMip,
+				FUpdateTextureRegion2D(0, 0, 0, 0, MipWidth, MipHeight), MipWidth * 4, MipData);
+		}
+		MipData += (int64)MipWidth * MipHeight * 4;
+	}
+}
+
+void FInVideoUploadScheduler::Startup()
+{
+	check(IsInGameThread());
+	if (!GScheduler.IsValid())
+	{
+		GScheduler.Reset(new FInVideoUploadScheduler());
+		GScheduler->m_EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(GScheduler.Get(), &FInVideoUploadScheduler::OnEndFrame);
+	}
+}
+
+void FInVideoUploadScheduler::Shutdown()
+{
+	if (!GScheduler.IsValid())
+	{
+		return;
+	}
+	FCoreDelegates::OnEndFrame.Remove(GScheduler->m_EndFrameHandle);
+	// 已发出的渲染命令引用调度器
+	FlushRenderingCommands();
+	GScheduler.Reset();
+}
+
+FInVideoUploadScheduler& FInVideoUploadScheduler::Get()
+{
+	check(GScheduler.IsValid());
+	return *GScheduler;
+}
+
+bool FInVideoUploadScheduler::Submit(FInVideoUpload&& Upload)
+{
+	FScopeLock Lock(&m_Mutex);
+	return SubmitLocked(MoveTemp(Upload));
+}
+
+int32 FInVideoUploadScheduler::Submit(TArray<FInVideoUpload>& Batch)
+{
+	int32 Superseded = 0;
+	{
+		FScopeLock Lock(&m_Mutex);
+		for (FInVideoUpload& Upload : Batch)
+		{
+			Superseded += SubmitLocked(MoveTemp(Upload)) ? 1 : 0;
+		}
+	}
+	Batch.Reset();
+	return Superseded;
+}
+
+bool FInVideoUploadScheduler::SubmitLocked(FInVideoUpload&& Upload)
+{
+	if (nullptr != Upload.Owner)
+	{
+		// 提交者数量只有几十个，线性查找即可
+		for (FInVideoUpload& Pending : m_Pending)
+		{
+			if (Pending.Owner == Upload.Owner)
+			{
+				// 旧帧的缓冲区引用在这里释放
+				Pending = MoveTemp(Upload);
+				INC_DWORD_STAT(STAT_InVideo_SupersededUploads);
+				return true;
+			}
+		}
+	}
+	m_Pending.Add(MoveTemp(Upload));
+	return false;
+}
+
+void FInVideoUploadScheduler::OnEndFrame()
+{
+	{
+		FScopeLock Lock(&m_Mutex);
+		if (m_bFlushQueued || m_Pending.Num() == 0)
+		{
+			return;
+		}
+		m_bFlushQueued = true;
+	}
+	ENQUEUE_RENDER_COMMAND(InVideoFlushUploads)([this](FRHICommandListImmediate& RHICmdList)
+		{
+			Flush_RenderThread(RHICmdList);
+		});
+}
+
+void FInVideoUploadScheduler::Flush_RenderThread(FRHICommandListImmediate& RHICmdList)
+{
+	SCOPE_CYCLE_COUNTER(STAT_InVideo_UploadFlush);
+	{
+		// 之后提交的上传进入下一帧
+		FScopeLock Lock(&m_Mutex);
+		Swap(m_Pending, m_Executing);
+		m_bFlushQueued = false;
+	}
+	for (const FInVideoUpload& Upload : m_Executing)
+	{
+		Upload.Execute(RHICmdList);
+	}
+	SET_DWORD_STAT(STAT_InVideo_UploadsPerFrame, m_Executing.Num());
+	// RHIUpdateTexture2D 返回后数据已被拷走，释放引用即把缓冲区还给池
+	m_Executing.Reset();
+}
@@ -9,26 +9,119 @@
 #include "MDModelDisplayConfig.h"
 #include "MDModelDisplayDragger.h"
 #include "MDModelDisplayUtils.h"
+#include "InVideoPixelConvert.h"
 #include "Async/Async.h"
 #include "Rendering/Texture2DResource.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "TextureResource.h"
+
+namespace
+{
+	// 暂停或队列为空时的轮询间隔，新帧到达会通过 Wake 提前唤醒
+	constexpr double PresentIdleSeconds = 0.05;
+	// 超过该时长没有被绘制视为不可见；可见控件每帧都会绘制
+	constexpr double HiddenAfterSeconds = 0.25;
+	// 跟随控件尺寸时，任一方向变化超过 1/8 才重新设置输出尺寸，避免布局动画期间反复缩放
+	constexpr int32 FitToWidgetHysteresisDivisor = 8;
+
+	// 解码端推帧时唤醒的显示任务。订阅在注册显示任务之前完成，句柄随后填入；之前推入的帧由首次 Tick 取走
+	struct FPresentWakeTarget
+	{
+		FCriticalSection Mutex;
+		FInVideoWorkerPool::FTaskHandle Task;
+
+		void Wake()
+		{
+			FScopeLock Lock(&Mutex);
+			FInVideoWorkerPool::Get().Wake(Task);
+		}
+	};
+
+	EInVideoDecodeThrottle ToDecodeThrottle(EInVideoOffscreenPolicy Policy)
+	{
+		switch (Policy)
+		{
+		case EInVideoOffscreenPolicy::ReduceRate:
+			return EInVideoDecodeThrottle::ReduceRate;
+		case EInVideoOffscreenPolicy::KeyframesOnly:
+			return EInVideoDecodeThrottle::KeyframesOnly;
+		case EInVideoOffscreenPolicy::Suspend:
+			return EInVideoDecodeThrottle::Suspend;
+		default:
+			return EInVideoDecodeThrottle::None;
+		}
+	}
+
+	// 设置控件显示的纹理和 UV 范围，只在游戏线程调用
+	void ApplyWidgetBrush(const TWeakObjectPtr<UInVideoWidget>& Widget, UTexture* Texture, const FBox2f& UVRegion)
+	{
+		if (!Widget.IsValid() || !Widget->ImageVideo || (Texture && !Texture->IsValidLowLevel()))
+		{
+			return;
+		}
+		FSlateBrush Brush = Widget->ImageVideo->GetBrush();
+		Brush.SetResourceObject(Texture);
+		Brush.SetUVRegion(UVRegion);
+		// Brush 未变化时 SetBrush 不会触发重绘失效
+		Widget->ImageVideo->SetBrush(Brush);
+	}
+
+	void SetWidgetBrush(TWeakObjectPtr<UInVideoWidget> Widget, UTexture* Texture, const FBox2f& UVRegion)
+	{
+		AsyncTask(ENamedThreads::GameThread, [Widget, Texture, UVRegion]()
+			{
+				ApplyWidgetBrush(Widget, Texture, UVRegion);
+			});
+	}
+
+	// 控件仍显示 Expected 时清除；预加载切换后控件已显示新播放器的纹理，不能被旧播放器清掉
+	void ClearWidgetBrush(TWeakObjectPtr<UInVideoWidget> Widget, UTexture* Expected)
+	{
+		if (nullptr == Expected)
+		{
+			return;
+		}
+		AsyncTask(ENamedThreads::GameThread, [Widget, Expected]()
+			{
+				if (Widget.IsValid() && Widget->ImageVideo && Widget->ImageVideo->GetBrush().GetResourceObject() == Expected)
+				{
+					ApplyWidgetBrush(Widget, nullptr, FBox2f(FVector2f::ZeroVector, FVector2f(1.0f, 1.0f)));
+				}
+			});
+	}
+}
 
 void UInVideoWidget::NativeConstruct()
 {
 	UE_LOG(LogTemp, Log, TEXT("UInVideoWidget NativeConstruct"));
 	Super::NativeConstruct();
+	// 可见性依赖每帧的 NativePaint，不能被 InvalidationBox 缓存跳过绘制
+	ForceVolatile(true);
 }
 void UInVideoWidget::NativeDestruct()
 {
 	UE_LOG(LogTemp, Log, TEXT("UInVideoWidget NativeDestruct"));
+	CancelPreload();
 	StopPlay();
 	Super::NativeDestruct();
 }
+int32 UInVideoWidget::NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	// Slate 不绘制折叠、隐藏以及被父级裁剪到视口外的控件，被绘制即视为可见
+	if (m_VideoPlayPtr.IsValid())
+	{
+		const FVector2D PixelSize = AllottedGeometry.GetAbsoluteSize();
+		m_VideoPlayPtr->ReportPainted(FIntPoint(FMath::RoundToInt(PixelSize.X), FMath::RoundToInt(PixelSize.Y)));
+	}
+	return Super::NativePaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+}
 
 
 void UInVideoWidget::StartPlay(const FString VideoURL, FDelegatePlayFailed Failed, FDelegateFirstFrame FirstFrame,const bool RealMode , const int Fps)
 {
 	StopPlay();
-	m_VideoPlayPtr = MakeUnique<VideoPlay>();
+	m_VideoPlayPtr = CreateVideoPlay();
 	m_VideoPlayPtr->StartPlay(VideoURL, Failed, FirstFrame, RealMode, Fps,this);
 }
 void UInVideoWidget::StopPlay()
@@ -42,6 +135,64 @@ void UInVideoWidget::StopPlay()
 		 ptr->StopPlay();
 		});
 }
+void UInVideoWidget::PreloadNext(const FString VideoURL, FDelegatePlayFailed Failed, FDelegateFirstFrame FirstFrame,
+	const bool RealMode, const int Fps, int32 ModelIndex)
+{
+	CancelPreload();
+	m_PreloadPtr = CreateVideoPlay();
+	// 预加载的队列满后解码器等待，共享源会拖住正在播放同一 URL 的控件，因此总是独占解码器
+	m_PreloadPtr->SetShareSource(false);
+	m_PreloadPtr->SetProfileModelIndex(ModelIndex);
+	if (m_VideoPlayPtr.IsValid())
+	{
+		m_PreloadPtr->CopyDelegatesFrom(*m_VideoPlayPtr);
+	}
+	m_PreloadPtr->SetPreroll(true);
+	m_PreloadPtr->StartPlay(VideoURL, Failed, FirstFrame, RealMode, Fps, this);
+}
+bool UInVideoWidget::PlayPreloaded()
+{
+	if (!m_PreloadPtr.IsValid())
+	{
+		return false;
+	}
+	TUniquePtr<VideoPlay> Next = MoveTemp(m_PreloadPtr);
+	// 先把控件切到新片段的首帧，旧播放器停止时发现控件已不显示它的纹理就不会清除
+	Next->Activate();
+	StopPlay();
+	m_VideoPlayPtr = MoveTemp(Next);
+	return true;
+}
+void UInVideoWidget::CancelPreload()
+{
+	if (!m_PreloadPtr.IsValid())
+	{
+		return;
+	}
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [ptr = MoveTemp(m_PreloadPtr)]()
+		{
+			ptr->StopPlay();
+		});
+}
+bool UInVideoWidget::IsPreloadReady() const
+{
+	return m_PreloadPtr.IsValid() && m_PreloadPtr->IsPrerollReady();
+}
+TUniquePtr<VideoPlay> UInVideoWidget::CreateVideoPlay() const
+{
+	TUniquePtr<VideoPlay> Player = MakeUnique<VideoPlay>();
+	Player->SetFrameQueue(FrameQueueDepth, FrameQueueFullPolicy);
+	Player->SetUploadBufferCount(UploadBufferCount);
+	Player->SetUploadMode(UploadMode);
+	Player->SetReverseCacheMemory(ReverseCacheMemoryMB);
+	Player->SetGaplessLoop(bGaplessLoop, LoopHeadFrames);
+	Player->SetLiveMode(bLiveMode, LiveOpenTimeoutMs, LiveReadTimeoutMs, LiveStaleThresholdMs);
+	Player->SetReconnect(bAutoReconnect, ReconnectInitialDelaySeconds, ReconnectMaxDelaySeconds, ReconnectMaxAttempts);
+	Player->SetShareSource(bShareDecoder);
+	Player->SetOffscreenPolicy(OffscreenPolicy, OffscreenFps);
+	Player->SetTextureOptions(TextureMipCount, bFitTextureToWidget);
+	return Player;
+}
 
 void UInVideoWidget::SetPlayRate(float Rate)
 {
@@ -128,6 +279,30 @@ void UInVideoWidget::BindOnVideoFileNotFound(FDelegateVideoFileNotFound Delegate
 	}
 }
 
+void UInVideoWidget::BindOnLiveStale(FDelegateLiveStale Delegate)
+{
+	if (m_VideoPlayPtr.IsValid())
+	{
+		m_VideoPlayPtr->BindLiveStaleDelegate(Delegate);
+	}
+}
+
+void UInVideoWidget::BindOnReconnecting(FDelegateReconnecting Delegate)
+{
+	if (m_VideoPlayPtr.IsValid())
+	{
+		m_VideoPlayPtr->BindReconnectingDelegate(Delegate);
+	}
+}
+
+void UInVideoWidget::BindOnRecovered(FDelegateRecovered Delegate)
+{
+	if (m_VideoPlayPtr.IsValid())
+	{
+		m_VideoPlayPtr->BindRecoveredDelegate(Delegate);
+	}
+}
+
 void UInVideoWidget::ContinuePlay(int32 FrameIndex)
 {
 	if (m_VideoPlayPtr.IsValid())
@@ -160,6 +335,23 @@ void UInVideoWidget::LoadVideoURLFromProfile(FString PlayCase)
 	}
 }
 
+void UInVideoWidget::SetOccluded(bool bOccluded)
+{
+	if (m_VideoPlayPtr.IsValid())
+	{
+		m_VideoPlayPtr->SetOccluded(bOccluded);
+	}
+}
+
+FInVideoPlayerStats UInVideoWidget::GetPlayerStats() const
+{
+	if (m_VideoPlayPtr.IsValid())
+	{
+		return m_VideoPlayPtr->GetStats();
+	}
+	return FInVideoPlayerStats();
+}
+
 
 
 
@@ -174,12 +366,102 @@ void VideoPlay::StartPlay(const FString VideoURL, FDelegatePlayFailed Failed, FD
 	UE_LOG(LogTemp, Warning, TEXT("VideoPlay::LoadVideoURLFromProfile - URL Exist!Start to play in %s"),*m_VideoURL);
 	m_RealMode = RealMode;
 	m_Fps = Fps;
-	m_UpdateTime = 1000 / m_Fps;
+	m_UpdateTime = 1000.0f / FMath::Max(1, m_Fps); // 流没有帧率信息时的帧间隔
 	m_Failed = Failed;
 	m_FirstFrame = FirstFrame;
 	m_BFirstFrame = false;
+	m_UploadBufferPool = FUploadBufferPool::Create(m_UploadBufferCount);
+	m_PlaneTextures = MakeShared<FInVideoPlaneTextures, ESPMode::ThreadSafe>();
+	m_Surface = MakeShared<FInVideoSurface, ESPMode::ThreadSafe>(
+		m_UploadMode == EInVideoUploadMode::Native ? EInVideoSurfaceKind::RenderTarget : EInVideoSurfaceKind::Texture);
+	m_bPrerollShown = false;
+	m_bWasPreroll = false;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_PrerollTexture = nullptr;
+		m_StartSeconds = FPlatformTime::Seconds();
+		m_FirstFrameLatencyMs = 0.0f;
+	}
 	UE_LOG(LogTemp, Log, TEXT("VideoPlay StartPlay Enter"));
-	m_Thread = FRunnableThread::Create(this, TEXT("Video Thread"));
+
+	// 直播模式只对网络流生效
+	m_bLiveActive = m_bLiveMode && FInVideoDecoder::IsNetworkURL(m_VideoURL);
+	if (m_bLiveMode && !m_bLiveActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("VideoPlay 直播模式仅支持网络流, 按普通模式播放 url=%s"), *m_VideoURL);
+	}
+
+	// 解码阶段：解码源填充帧队列；直播时最多缓冲 2 帧并覆盖旧帧，延迟不会无限增长
+	if (m_bLiveActive)
+	{
+		m_FrameRing.Reset(FMath::Min(m_FrameQueueDepth, 2), EInVideoQueueFullPolicy::DropOldest);
+	}
+	else
+	{
+		m_FrameRing.Reset(m_FrameQueueDepth, m_FrameQueuePolicy);
+	}
+	m_LastLivePresentSeconds = FPlatformTime::Seconds();
+	m_LiveBaselineOffsetMs = TNumericLimits<double>::Max();
+	m_bLiveStale = false;
+	m_LastPresentedIndex = INDEX_NONE;
+	// 网络实时流由源决定节奏，其余按 PTS 调度
+	m_bPacedByClock = !m_bLiveActive && !(m_RealMode && FInVideoDecoder::IsNetworkURL(m_VideoURL));
+	m_bHasPendingFrame = false;
+	m_Clock.Reset();
+	// 首次绘制之前按可见处理，超过 HiddenAfterSeconds 仍未绘制再节流
+	m_LastPaintCycles = FPlatformTime::Cycles64();
+	m_bVisible = true;
+	m_FitOutputSize = FIntPoint::ZeroValue;
+
+	m_bWasPaused = false;
+
+	FInVideoSourceOptions Options;
+	Options.bRealMode = m_RealMode;
+	Options.bNativeOutput = m_UploadMode == EInVideoUploadMode::Native;
+	Options.bLive = m_bLiveActive;
+	Options.OpenTimeoutMs = m_LiveOpenTimeoutMs;
+	Options.ReadTimeoutMs = m_LiveReadTimeoutMs;
+	Options.bGaplessLoop = m_bGaplessLoop;
+	Options.LoopHeadFrames = m_LoopHeadFrames;
+	Options.ReverseCacheBytes = (int64)m_ReverseCacheMB * 1024 * 1024;
+	Options.bReverse = m_bReverse;
+	Options.bAutoReconnect = m_bAutoReconnect;
+	Options.ReconnectInitialDelay = m_ReconnectInitialDelay;
+	Options.ReconnectMaxDelay = m_ReconnectMaxDelay;
+	Options.ReconnectMaxAttempts = m_ReconnectMaxAttempts;
+	m_Source = FInVideoSource::Acquire(m_VideoURL, Options, m_bShareSource);
+
+	FInVideoSourceSubscriber Subscriber;
+	Subscriber.Ring = &m_FrameRing;
+	Subscriber.OutputSize = GetOutputSize();
+	Subscriber.bShrinkOnly = !m_bCustomResolution;
+	Subscriber.bPaused = m_bPaused;
+	Subscriber.ThrottleFps = m_OffscreenFps;
+	TSharedRef<FPresentWakeTarget, ESPMode::ThreadSafe> WakeTarget = MakeShared<FPresentWakeTarget, ESPMode::ThreadSafe>();
+	Subscriber.OnFramePushed = [WakeTarget]() { WakeTarget->Wake(); };
+	Subscriber.OnFailed = [this]() { NotifyFailed(); };
+	Subscriber.OnFirstPlayCompleted = [this]()
+		{
+			m_bFirstPlayCompleted = true;
+			NotifyFirstPlayCompleted();
+		};
+	Subscriber.OnReconnecting = [this](int32 Attempt, float DelaySeconds) { NotifyReconnecting(Attempt); };
+	Subscriber.OnRecovered = [this]()
+		{
+			m_bResetLiveBaseline = true;
+			NotifyRecovered();
+		};
+	Subscriber.OnSeekApplied = [this]() { m_bDiscardPending = true; };
+	Subscriber.OnReverseChanged = [this](bool bReverse) { m_bReverse = bReverse; };
+	m_SubscriberId = m_Source->Subscribe(MoveTemp(Subscriber));
+
+	// 显示阶段：在共享工作线程池上按播放时钟从队列取帧并上传纹理，解码出新帧时唤醒。
+	// Tick 会读取 m_Source/m_SubscriberId，订阅完成后才注册
+	m_PresentTask = FInVideoWorkerPool::Get().Register(TEXT("Present ") + m_VideoURL, [this](double NowSeconds) { return Tick(NowSeconds); });
+	{
+		FScopeLock Lock(&WakeTarget->Mutex);
+		WakeTarget->Task = m_PresentTask;
+	}
 	UE_LOG(LogTemp, Log, TEXT("VideoPlay StartPlay END"));
 }
 void VideoPlay::BindFirstPlayCompletedDelegate(FDelegateFirstPlayCompleted Delegate)
@@ -198,6 +480,42 @@ void VideoPlay::NotifyFirstPlayCompleted()
 				FirstPlayCompleted.Execute();
 		});
 }
+void VideoPlay::BindLiveStaleDelegate(FDelegateLiveStale Delegate)
+{
+	m_LiveStale = Delegate;
+}
+void VideoPlay::NotifyLiveStale()
+{
+	AsyncTask(ENamedThreads::GameThread, [LiveStale = m_LiveStale]()
+		{
+			if (LiveStale.IsBound())
+				LiveStale.Execute();
+		});
+}
+void VideoPlay::BindReconnectingDelegate(FDelegateReconnecting Delegate)
+{
+	m_Reconnecting = Delegate;
+}
+void VideoPlay::BindRecoveredDelegate(FDelegateRecovered Delegate)
+{
+	m_Recovered = Delegate;
+}
+void VideoPlay::NotifyReconnecting(int32 Attempt)
+{
+	AsyncTask(ENamedThreads::GameThread, [Reconnecting = m_Reconnecting, Attempt]()
+		{
+			if (Reconnecting.IsBound())
+				Reconnecting.Execute(Attempt);
+		});
+}
+void VideoPlay::NotifyRecovered()
+{
+	AsyncTask(ENamedThreads::GameThread, [Recovered = m_Recovered]()
+		{
+			if (Recovered.IsBound())
+				Recovered.Execute();
+		});
+}
 void VideoPlay::NotifyVideoFileNotFound()
 {
 	AsyncTask(ENamedThreads::GameThread, [VideoFileNotFound = m_VideoFileNotFound]()
@@ -210,34 +528,35 @@ void VideoPlay::StopPlay()
 {
 	UE_LOG(LogTemp, Log, TEXT("VideoPlay StopPlay Enter"));
 	m_Stopping = true;
-	if (nullptr != m_Thread)
+	m_FrameRing.Wake();
+	if (m_PresentTask.IsValid())
 	{
-		m_Thread->Kill();
-		delete m_Thread;
-		m_Thread = nullptr;
+		// 等待正在执行的 Tick 结束
+		FInVideoWorkerPool::Get().Unregister(m_PresentTask);
+		m_PresentTask.Reset();
 	}
-	if (nullptr != m_WrapOpenCv)
+	if (m_Source.IsValid())
 	{
-		if (m_WrapOpenCv->m_Stream.isOpened())
-		{
-			m_WrapOpenCv->m_Stream.release();
-		}
-		delete m_WrapOpenCv;
-		m_WrapOpenCv = nullptr;
+		// 返回后源不再写入本实例的队列，最后一个订阅者释放时停止解码
+		m_Source->Unsubscribe(m_SubscriberId);
+		m_Source.Reset();
+		m_SubscriberId = INDEX_NONE;
 	}
-	if (nullptr != m_VideoUpdateTextureRegion)
+	m_FrameRing.Clear();
+	m_Clock.LogSummary(m_VideoURL);
+	if (m_Surface.IsValid())
 	{
-		delete m_VideoUpdateTextureRegion;
-		m_VideoUpdateTextureRegion = nullptr;
+		// 纹理归还到池中会被其他播放器复用，先让控件不再引用它
+		ClearWidgetBrush(m_widget, m_BrushTexture);
+		m_BrushTexture = nullptr;
+		m_Surface->Release();
+		m_Surface.Reset();
+	}
+	if (m_PlaneTextures.IsValid())
+	{
+		// 平面纹理在渲染线程释放
+		ENQUEUE_RENDER_COMMAND(InVideoReleasePlanes)([Planes = MoveTemp(m_PlaneTextures)](FRHICommandListImmediate& RHICmdList) {});
 	}
-	AsyncTask(ENamedThreads::GameThread, [vt = VideoTexture]()
-		{
-			if (vt->IsValidLowLevel()) 
-			{
-				vt->RemoveFromRoot();
-			}
-		});
-	m_VideoSize = FVector2D(0, 0);
 	UE_LOG(LogTemp, Log, TEXT("UInVideoWidget StopPlay END"));
 }
 
@@ -249,6 +568,10 @@ void VideoPlay::SetPlayRate(float Rate)
 void VideoPlay::SetReverse(bool bReverse)
 {
 	m_bReverse = bReverse;
+	if (m_Source.IsValid())
+	{
+		m_Source->SetReverse(bReverse);
+	}
 }
 
 void VideoPlay::SetResolution(const FVector2D& NewResolution)
@@ -262,6 +585,11 @@ void VideoPlay::SetResolution(const FVector2D& NewResolution)
 	{
 		m_bCustomResolution = false;
 	}
+	// 缩放在解码源完成，同尺寸的控件共用一次缩放
+	if (m_Source.IsValid())
+	{
+		m_Source->SetOutputSize(m_SubscriberId, GetOutputSize(), !m_bCustomResolution);
+	}
 }
 
 void VideoPlay::LoadVideoURLFromProfile(FString PlayCase)
@@ -270,18 +598,26 @@ void VideoPlay::LoadVideoURLFromProfile(FString PlayCase)
 	{
 		FString Path = FPaths::Combine(UMDModelDisplayUtils::GetProjectDirectory(), TEXT("Showcase"));
 		FPaths::NormalizeDirectoryName(Path);
-		FString MP4Name = m_widget->OwnerOverlay->ModelDisplayData[m_widget->OwnerOverlay->CurrentModelIndex].MP4Name;
-		FString PreviewMP4Name = m_widget->OwnerOverlay->ModelDisplayData[m_widget->OwnerOverlay->CurrentModelIndex].PreviewMP4;
-		FString IntroMP4 = m_widget->OwnerOverlay->ModelDisplayData[m_widget->OwnerOverlay->CurrentModelIndex].IntroMP4;
+		// 预加载可以指定下一个模型，否则使用当前模型
+		const int32 ModelIndex = m_ProfileModelIndex != INDEX_NONE ? m_ProfileModelIndex : m_widget->OwnerOverlay->CurrentModelIndex;
+		if (!m_widget->OwnerOverlay->ModelDisplayData.IsValidIndex(ModelIndex))
+		{
+			UE_LOG(LogTemp, Error, TEXT("VideoPlay::LoadVideoURLFromProfile - 模型序号 %d 无效"), ModelIndex);
+			NotifyVideoFileNotFound();
+			return;
+		}
+		FString MP4Name = m_widget->OwnerOverlay->ModelDisplayData[ModelIndex].MP4Name;
+		FString PreviewMP4Name = m_widget->OwnerOverlay->ModelDisplayData[ModelIndex].PreviewMP4;
+		FString IntroMP4 = m_widget->OwnerOverlay->ModelDisplayData[ModelIndex].IntroMP4;
 
 		IFileManager& FileManager = IFileManager::Get();
 
 		TArray<FString> AllDirectories;
 		FileManager.FindFilesRecursive(AllDirectories, *Path, TEXT("*"), false, true);
 
-		FString m_MP4URL = FPaths::Combine(AllDirectories[m_widget->OwnerOverlay->CurrentModelIndex], MP4Name);
-		FString m_PreviewMP4URL = FPaths::Combine(AllDirectories[m_widget->OwnerOverlay->CurrentModelIndex], PreviewMP4Name);
-		FString m_IntroMP4URL = FPaths::Combine(AllDirectories[m_widget->OwnerOverlay->CurrentModelIndex], IntroMP4);
+		FString m_MP4URL = FPaths::Combine(AllDirectories[ModelIndex], MP4Name);
+		FString m_PreviewMP4URL = FPaths::Combine(AllDirectories[ModelIndex], PreviewMP4Name);
+		FString m_IntroMP4URL = FPaths::Combine(AllDirectories[ModelIndex], IntroMP4);
 		UE_LOG(LogTemp, Warning, TEXT("VideoPlay::LoadVideoURLFromProfile - Get Data!.MP4URL is %s"),*m_MP4URL);
 		UE_LOG(LogTemp, Warning, TEXT("VideoPlay::LoadVideoURLFromProfile - Get Data!.PreviewMP4Name is %s"), *m_PreviewMP4URL);
 		UE_LOG(LogTemp, Warning, TEXT("VideoPlay::LoadVideoURLFromProfile - Get Data!.IntroMP4 is %s"), *m_IntroMP4URL);
@@ -340,271 +676,559 @@ void VideoPlay::LoadVideoURLFromProfile(FString PlayCase)
 
 void VideoPlay::ContinuePlay(int32 FrameIndex)
 {
-	if (m_WrapOpenCv && m_WrapOpenCv->m_Stream.isOpened())
+	if (m_Source.IsValid())
 	{
 		if (FrameIndex >= 0)
 		{
 			m_CurrentFrameIndex = FrameIndex;
 		}
 
-		// 设置视频播放位置
-		m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-
-		// 如果线程已停止,重新启动
-		if (m_Stopping)
-		{
-			m_Stopping = false;
-			m_Thread = FRunnableThread::Create(this, TEXT("Video Thread"));
-		}
+		// 设置视频播放位置，由解码线程执行 Seek 并清空帧队列
+		m_Source->Seek(m_CurrentFrameIndex);
+		// 主动 Seek 不计入回绕卡顿，已取出但未显示的帧作废
+		m_LastPresentedIndex = INDEX_NONE;
+		m_bDiscardPending = true;
 	}
 }
 void VideoPlay::PausePlay()
 {
 	m_bPaused = true;
-
+	if (m_Source.IsValid())
+	{
+		m_Source->SetSubscriberPaused(m_SubscriberId, true);
+	}
 }
 void VideoPlay::ResumePlay()
 {
 	m_bPaused = false;
+	if (m_Source.IsValid())
+	{
+		m_Source->SetSubscriberPaused(m_SubscriberId, false);
+	}
+	FInVideoWorkerPool::Get().Wake(m_PresentTask);
 }
-bool VideoPlay::Init()
+void VideoPlay::SetFrameQueue(int32 Depth, EInVideoQueueFullPolicy Policy)
 {
+	m_FrameQueueDepth = FMath::Max(1, Depth);
+	m_FrameQueuePolicy = Policy;
+}
+void VideoPlay::SetUploadBufferCount(int32 Count)
+{
+	m_UploadBufferCount = FMath::Max(1, Count);
+}
+void VideoPlay::SetUploadMode(EInVideoUploadMode Mode)
+{
+	m_UploadMode = Mode;
+}
+void VideoPlay::SetReverseCacheMemory(int32 MegaBytes)
+{
+	m_ReverseCacheMB = FMath::Max(16, MegaBytes);
+}
+void VideoPlay::SetGaplessLoop(bool bEnable, int32 HeadFrames)
+{
+	m_bGaplessLoop = bEnable;
+	m_LoopHeadFrames = FMath::Max(1, HeadFrames);
+}
+void VideoPlay::SetLiveMode(bool bLive, int32 OpenTimeoutMs, int32 ReadTimeoutMs, int32 StaleThresholdMs)
+{
+	m_bLiveMode = bLive;
+	m_LiveOpenTimeoutMs = FMath::Max(100, OpenTimeoutMs);
+	m_LiveReadTimeoutMs = FMath::Max(100, ReadTimeoutMs);
+	m_LiveStaleThresholdMs = FMath::Max(100, StaleThresholdMs);
+}
+void VideoPlay::SetReconnect(bool bEnable, float InitialDelaySeconds, float MaxDelaySeconds, int32 MaxAttempts)
+{
+	m_bAutoReconnect = bEnable;
+	m_ReconnectInitialDelay = InitialDelaySeconds;
+	m_ReconnectMaxDelay = MaxDelaySeconds;
+	m_ReconnectMaxAttempts = MaxAttempts;
+}
+void VideoPlay::StartSyncMember(const FString& VideoURL, UInVideoWidget* widget)
+{
+	StopPlay();
+	m_widget = widget;
+	m_Stopping = false;
+	m_VideoURL = VideoURL;
+	m_BFirstFrame = false;
+	m_UploadBufferPool = FUploadBufferPool::Create(m_UploadBufferCount);
+	m_PlaneTextures = MakeShared<FInVideoPlaneTextures, ESPMode::ThreadSafe>();
+	m_Surface = MakeShared<FInVideoSurface, ESPMode::ThreadSafe>(
+		m_UploadMode == EInVideoUploadMode::Native ? EInVideoSurfaceKind::RenderTarget : EInVideoSurfaceKind::Texture);
+	UE_LOG(LogTemp, Log, TEXT("VideoPlay 作为同步组成员启动 url=%s"), *m_VideoURL);
+}
+void VideoPlay::PresentSyncedFrame(FInVideoFrame& Frame, FRenderBatch& Batch)
+{
+	Swap(m_PresentFrame, Frame);
+	m_CurrentFrameIndex = m_PresentFrame.FrameIndex;
+	NotifyFirstFrame();
+	m_RenderBatch = &Batch;
+	UpdateTexture();
+	m_RenderBatch = nullptr;
+}
+void VideoPlay::SubmitUpload(FInVideoUpload&& Upload)
+{
+	Upload.Owner = this;
+	if (nullptr != m_RenderBatch)
+	{
+		m_RenderBatch->Add(MoveTemp(Upload));
+		return;
+	}
+	if (FInVideoUploadScheduler::Get().Submit(MoveTemp(Upload)))
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		++m_SupersededUploads;
+	}
+}
+void VideoPlay::UpdateBrush(UTexture* Texture, const FBox2f& UVRegion)
+{
+	if (m_bPreroll)
+	{
+		// 预加载期间只记录，Activate 时由游戏线程直接设置
+		m_BrushTexture = Texture;
+		m_BrushUVRegion = UVRegion;
+		FScopeLock Lock(&m_StatsMutex);
+		m_PrerollTexture = Texture;
+		m_PrerollUVRegion = UVRegion;
+		return;
+	}
+	if (!m_bForceBrush.Exchange(false) && Texture == m_BrushTexture && UVRegion == m_BrushUVRegion)
+	{
+		return;
+	}
+	m_BrushTexture = Texture;
+	m_BrushUVRegion = UVRegion;
+	SetWidgetBrush(m_widget, Texture, UVRegion);
+}
+void VideoPlay::SetShareSource(bool bShare)
+{
+	m_bShareSource = bShare;
+}
+void VideoPlay::SetPreroll(bool bPreroll)
+{
+	m_bPreroll = bPreroll;
+}
+void VideoPlay::SetProfileModelIndex(int32 ModelIndex)
+{
+	m_ProfileModelIndex = ModelIndex;
+}
+void VideoPlay::CopyDelegatesFrom(const VideoPlay& Other)
+{
+	m_FirstPlayCompleted = Other.m_FirstPlayCompleted;
+	m_VideoFileNotFound = Other.m_VideoFileNotFound;
+	m_LiveStale = Other.m_LiveStale;
+	m_Reconnecting = Other.m_Reconnecting;
+	m_Recovered = Other.m_Recovered;
+}
+bool VideoPlay::IsPrerollReady() const
+{
+	FScopeLock Lock(&m_StatsMutex);
+	return nullptr != m_PrerollTexture;
+}
+void VideoPlay::Activate()
+{
+	check(IsInGameThread());
+	UTexture* Texture = nullptr;
+	FBox2f UVRegion;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		Texture = m_PrerollTexture;
+		UVRegion = m_PrerollUVRegion;
+		m_PrerollTexture = nullptr;
+		m_StartSeconds = FPlatformTime::Seconds();
+	}
+	m_LastPaintCycles = FPlatformTime::Cycles64();
+	// 首帧还没上传完时由显示线程在上传后设置 Brush
+	m_bForceBrush = nullptr == Texture;
+	m_bPreroll = false;
+	if (nullptr != Texture)
+	{
+		// 首帧已在 GPU 上，本帧就切换，不经过异步任务
+		ApplyWidgetBrush(m_widget, Texture, UVRegion);
+	}
+	FInVideoWorkerPool::Get().Wake(m_PresentTask);
+}
+void VideoPlay::SetOffscreenPolicy(EInVideoOffscreenPolicy Policy, float OffscreenFps)
+{
+	m_OffscreenPolicy = Policy;
+	m_OffscreenFps = FMath::Max(0.1f, OffscreenFps);
+}
+void VideoPlay::ReportPainted(FIntPoint PixelSize)
+{
+	// 尺寸为 0 的控件等同于不可见
+	if (PixelSize.X > 0 && PixelSize.Y > 0)
+	{
+		m_LastPaintCycles = FPlatformTime::Cycles64();
+	}
+	FScopeLock Lock(&m_StatsMutex);
+	m_OnScreenSize = PixelSize;
+}
+void VideoPlay::SetOccluded(bool bOccluded)
+{
+	m_bOccluded = bOccluded;
+	FInVideoWorkerPool::Get().Wake(m_PresentTask);
+}
+void VideoPlay::UpdateVisibility(double NowSeconds)
+{
+	const double SincePaintSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - m_LastPaintCycles);
+	const bool bVisible = m_OffscreenPolicy == EInVideoOffscreenPolicy::KeepPlaying
+		|| (!m_bOccluded && SincePaintSeconds < HiddenAfterSeconds);
+	if (bVisible == m_bVisible)
+	{
+		return;
+	}
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_bVisible = bVisible;
+	}
+	m_NextOffscreenUploadSeconds = NowSeconds;
+	UE_LOG(LogTemp, Verbose, TEXT("VideoPlay %s url=%s"), bVisible ? TEXT("恢复可见, 全速播放") : TEXT("不可见, 开始节流"), *m_VideoURL);
+	if (m_Source.IsValid())
+	{
+		m_Source->SetSubscriberThrottle(m_SubscriberId, bVisible ? EInVideoDecodeThrottle::None : ToDecodeThrottle(m_OffscreenPolicy), m_OffscreenFps);
+	}
+}
+bool VideoPlay::ShouldUpload(double NowSeconds)
+{
+	if (m_bVisible)
+	{
+		return true;
+	}
+	if (NowSeconds < m_NextOffscreenUploadSeconds)
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		++m_OffscreenSkippedUploads;
+		return false;
+	}
+	m_NextOffscreenUploadSeconds = NowSeconds + 1.0 / m_OffscreenFps;
 	return true;
 }
-uint32 VideoPlay::Run()
+void VideoPlay::SetTextureOptions(int32 MipCount, bool bFitToWidget)
+{
+	m_TextureMipCount = FMath::Clamp(MipCount, 1, 6);
+	m_bFitToWidget = bFitToWidget;
+}
+void VideoPlay::UpdateFitToWidget()
 {
-	UE_LOG(LogTemp, Log, TEXT("VideoPlay 打开视频流 进入"));
-	if (nullptr == m_WrapOpenCv)
+	if (!m_bFitToWidget || m_bCustomResolution || !m_bVisible)
 	{
-		m_WrapOpenCv = new WrapOpenCv();
+		return;
 	}
-
-	if (false == m_WrapOpenCv->m_Stream.open(TCHAR_TO_UTF8(*m_VideoURL)))
+	FIntPoint ScreenSize;
+	FIntPoint Current;
 	{
-		UE_LOG(LogTemp, Error, TEXT("VideoPlay 打开视频失败 url=%s"), *m_VideoURL);
-		NotifyFailed();
-		return -1;
+		FScopeLock Lock(&m_StatsMutex);
+		ScreenSize = m_OnScreenSize;
+		Current = m_FitOutputSize;
 	}
-
-	m_TotalFrames = m_WrapOpenCv->m_Stream.get(cv::CAP_PROP_FRAME_COUNT);
-	if (m_TotalFrames <= 0) {
-		UE_LOG(LogTemp, Error, TEXT("VideoPlay 获取视频总帧数失败或为0 url=%s"), *m_VideoURL);
-		m_WrapOpenCv->m_Stream.release();
-		delete m_WrapOpenCv;
-		m_WrapOpenCv = nullptr;
-		NotifyFailed();
-		return -1;
+	if (ScreenSize.X <= 0 || ScreenSize.Y <= 0)
+	{
+		return;
 	}
-	UE_LOG(LogTemp, Log, TEXT("VideoPlay 打开视频成功, 总帧数: %d"), m_TotalFrames);
-
-	// 初始化帧索引
-	m_CurrentFrameIndex = m_bReverse ? (m_TotalFrames - 1) : 0;
-	if (m_TotalFrames > 0) { // 只有在有帧的情况下才设置初始位置
-		m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
+	const FIntPoint Delta(FMath::Abs(ScreenSize.X - Current.X), FMath::Abs(ScreenSize.Y - Current.Y));
+	if (Current != FIntPoint::ZeroValue
+		&& Delta.X * FitToWidgetHysteresisDivisor <= Current.X && Delta.Y * FitToWidgetHysteresisDivisor <= Current.Y)
+	{
+		return;
 	}
-
-	m_LastReadTime = FDateTime::Now(); // 初始化上次读取时间
-
-	UE_LOG(LogTemp, Log, TEXT("VideoPlay Run 运行循环 进入"));
-	while (false == m_Stopping)
 	{
-		if (m_bPaused)
+		FScopeLock Lock(&m_StatsMutex);
+		m_FitOutputSize = ScreenSize;
+	}
+	UE_LOG(LogTemp, Verbose, TEXT("VideoPlay 输出尺寸跟随控件 %dx%d url=%s"), ScreenSize.X, ScreenSize.Y, *m_VideoURL);
+	if (m_Source.IsValid())
+	{
+		m_Source->SetOutputSize(m_SubscriberId, ScreenSize, true);
+	}
+}
+FIntPoint VideoPlay::GetOutputSize() const
+{
+	if (m_bCustomResolution)
+	{
+		return FIntPoint(m_TargetResolution.X, m_TargetResolution.Y);
+	}
+	FScopeLock Lock(&m_StatsMutex);
+	return m_bFitToWidget ? m_FitOutputSize : FIntPoint::ZeroValue;
+}
+FInVideoPlayerStats VideoPlay::GetStats() const
+{
+	FInVideoPlayerStats Stats;
+	Stats.FrameQueueDepth = m_FrameRing.Num();
+	Stats.FrameQueueDropped = m_FrameRing.GetDroppedCount();
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		Stats.LoopCount = m_LoopCount;
+		Stats.LastLoopHitchMs = m_LastLoopHitchMs;
+		Stats.MaxLoopHitchMs = m_MaxLoopHitchMs;
+		Stats.LiveSkippedFrames = m_LiveSkippedFrames;
+		Stats.LiveLatencyMs = m_LiveLatencyMs;
+		Stats.bLiveLatencyAbsolute = m_bLiveLatencyAbsolute;
+		Stats.bLiveStale = m_bLiveStale;
+		Stats.OnScreenSize = m_OnScreenSize;
+		Stats.OffscreenSkippedUploads = m_OffscreenSkippedUploads;
+		Stats.SurfacePendingFrames = m_SurfacePendingFrames;
+		Stats.SupersededUploads = m_SupersededUploads;
+		Stats.FirstFrameLatencyMs = m_FirstFrameLatencyMs;
+		Stats.bVisible = m_bVisible;
+	}
+	m_Clock.FillStats(Stats);
+	if (m_Source.IsValid())
+	{
+		m_Source->GetStats(Stats);
+	}
+	return Stats;
+}
+double VideoPlay::Tick(double NowSeconds)
+{
+	if (m_Stopping)
+	{
+		return -1.0;
+	}
+	if (m_bPreroll)
+	{
+		return PrerollStep(NowSeconds);
+	}
+	if (m_bWasPreroll)
+	{
+		// 预加载结束，首帧已由 Activate 显示，时钟从下一帧开始
+		m_bWasPreroll = false;
+		if (m_bPrerollShown)
 		{
-			FPlatformProcess::Sleep(0.01f);
-			continue;
+			NotifyFirstFrame();
 		}
-
-		if (false == m_WrapOpenCv->m_Stream.isOpened())
+	}
+	UpdateVisibility(NowSeconds);
+	UpdateFitToWidget();
+	// 不可见挂起时与暂停相同：时钟停止，直播也不计入断流
+	const bool bSuspended = !m_bVisible && m_OffscreenPolicy == EInVideoOffscreenPolicy::Suspend;
+	if (m_bPaused || bSuspended)
+	{
+		if (!m_bWasPaused)
 		{
-			UE_LOG(LogTemp, Error, TEXT("VideoPlay Run 循环中发现视频流未打开"));
-			NotifyFailed();
-			return -1;
+			m_bWasPaused = true;
+			m_Clock.Pause(NowSeconds);
 		}
+		// 恢复播放时会被唤醒，恢复可见在下一次轮询时检测到
+		return NowSeconds + PresentIdleSeconds;
+	}
+	if (m_bWasPaused)
+	{
+		m_bWasPaused = false;
+		m_Clock.Resume();
+		m_LastLivePresentSeconds = NowSeconds;
+	}
+	return PresentStep(NowSeconds);
+}
+bool VideoPlay::PopFrame(FInVideoFrame& OutFrame)
+{
+	if (!m_FrameRing.Pop(OutFrame))
+	{
+		return false;
+	}
+	// 队列腾出了空位，继续分发等待中的帧并唤醒解码任务
+	if (m_Source.IsValid())
+	{
+		m_Source->OnSubscriberPopped();
+	}
+	return true;
+}
+double VideoPlay::PresentStep(double NowSeconds)
+{
+	if (m_bLiveActive)
+	{
+		return PresentLive(NowSeconds);
+	}
 
-		// --- 非实时模式处理 (优化后) ---
-		if (false == m_RealMode)
+	// --- 网络实时流: 队列中有帧立即显示，节奏由源决定 ---
+	if (!m_bPacedByClock)
+	{
+		if (!PopFrame(m_PresentFrame))
 		{
-			// 1. 时间控制: 检查是否到达下一帧的显示时间
-			auto DataNow = FDateTime::Now();
-			double ElapsedMs = (DataNow - m_LastReadTime).GetTotalMilliseconds();
-			double TargetIntervalMs = m_UpdateTime / m_PlayRate; // m_UpdateTime = 1000 / m_Fps
-
-			if (ElapsedMs < TargetIntervalMs)
-			{
-				// 时间未到，短暂休眠避免忙等
-				// 可以根据剩余时间调整休眠时长，但简单固定值通常足够
-				FPlatformProcess::Sleep(FMath::Max(0.001f, (float)(TargetIntervalMs - ElapsedMs) / 2000.0f)); // 休眠剩余时间的一半，但不小于1ms
-				continue; // 继续检查时间
-			}
-
-			// 时间已到或超过，更新上次读取时间 (即使读取失败也要更新，防止卡死)
-			// 使用实际经过的时间来计算跳过的帧数，更精确地模拟播放速率
-			int32 framesToSkip = FMath::Max(0, FMath::FloorToInt(ElapsedMs / TargetIntervalMs) - 1);
-			m_LastReadTime = DataNow; // 或者 m_LastReadTime += FTimespan::FromMilliseconds(TargetIntervalMs * (framesToSkip + 1)); // 理论上更精确，但可能累积误差
-
-			bool bFrameReadSuccess = false;
+			// 新帧到达时由解码任务唤醒
+			return NowSeconds + PresentIdleSeconds;
+		}
+		m_CurrentFrameIndex = m_PresentFrame.FrameIndex;
+		NotifyFirstFrame();
+		TrackLoopHitch(m_UpdateTime);
+		if (ShouldUpload(NowSeconds))
+		{
+			UpdateTexture();
+		}
+		return NowSeconds;
+	}
 
-			// 2. 反向播放处理 (仍然需要 Seek)
-			if (m_bReverse)
-			{
-				// 反向播放优化空间有限，仍然需要seek
-				// 可以考虑优化 frameStep 计算，例如基于 TargetIntervalMs 和实际 ElapsedMs
-				// 但基本逻辑不变：计算目标帧号 -> seek -> read
-				int32 frameStep = FMath::Max(1, FMath::RoundToInt((ElapsedMs / (1000.0 / m_Fps)) * m_PlayRate)); // 基于实际流逝时间和目标帧率计算步进
-				m_CurrentFrameIndex -= frameStep;
+	// --- 文件源: 按 PTS 和单调时钟决定显示、等待或丢弃 ---
+	const double StreamFrameMs = m_Source.IsValid() ? m_Source->GetFrameDurationMs() : 0.0;
+	const double FrameDurationMs = StreamFrameMs > 0.0 ? StreamFrameMs : m_UpdateTime;
+	m_Clock.SetRate(m_PlayRate, m_bReverse);
+	if (m_bDiscardPending.Exchange(false))
+	{
+		m_bHasPendingFrame = false;
+		// Seek 后帧号可能沿播放方向跳跃，不能沿用旧的基准排期
+		m_Clock.Resume();
+	}
 
-				if (m_CurrentFrameIndex < 0)
-				{
-					UE_LOG(LogTemp, Verbose, TEXT("非实时模式: 索引回绕 (反向): Index %d < 0. 重置为最后一帧 %d."), m_CurrentFrameIndex, m_TotalFrames - 1);
-					m_CurrentFrameIndex = m_TotalFrames - 1; // 回绕到最后一帧
-					// 反向播放完成一轮 (从头到尾)
-					if (!m_bFirstPlayCompleted) // 只有首次反向播完触发
-					{
-						// 注意：反向播放的“完成”概念可能需要重新定义，这里暂时不触发
-						// m_bFirstPlayCompleted = true;
-						// NotifyFirstPlayCompleted();
-					}
-					// Seek 到循环点
-					m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-				}
-				else
-				{
-					// 正常反向 Seek
-					m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-				}
+	if (!m_bHasPendingFrame)
+	{
+		if (!PopFrame(m_PendingFrame))
+		{
+			// 解码暂时跟不上，画面保持上一帧，新帧到达时被唤醒
+			return NowSeconds + PresentIdleSeconds;
+		}
+		m_bHasPendingFrame = true;
+		m_PendingDueSeconds = m_Clock.Schedule(m_PendingFrame.FrameIndex, m_PendingFrame.PtsMs, FrameDurationMs, FPlatformTime::Seconds());
+	}
 
-				// 尝试读取
-				if (m_WrapOpenCv->m_Stream.read(m_WrapOpenCv->m_Frame))
-				{
-					bFrameReadSuccess = true;
-					// 读取成功后，可以获取实际读取到的帧号，更新 m_CurrentFrameIndex 以提高准确性
-					// m_CurrentFrameIndex = m_WrapOpenCv->m_Stream.get(cv::CAP_PROP_POS_FRAMES) - 1; // get返回的是下一帧的索引
-				}
-			}
-			// 3. 正向播放处理 (优化核心：顺序读取)
-			else // m_bReverse == false
-			{
-				// 跳过因时间流逝需要跳过的帧 (模拟快进)
-				for (int32 i = 0; i < framesToSkip; ++i)
-				{
-					if (!m_WrapOpenCv->m_Stream.grab()) // grab() 比 read() 更快，因为它只抓取帧数据不解码
-					{
-						// 如果抓取失败，可能到了视频末尾
-						break;
-					}
-					m_CurrentFrameIndex++; // 也要更新索引计数
-				}
+	const double Now = FPlatformTime::Seconds();
+	const double Remaining = m_PendingDueSeconds - Now;
+	if (Remaining > 0.0)
+	{
+		// 未到显示时刻，当前画面继续保留，由线程池在到期时再调度
+		return m_PendingDueSeconds;
+	}
 
-				// 读取当前目标帧
-				if (m_WrapOpenCv->m_Stream.read(m_WrapOpenCv->m_Frame))
-				{
-					bFrameReadSuccess = true;
-					m_CurrentFrameIndex++; // 更新索引到下一帧的位置
-				}
+	// 下一帧的显示时刻也已经过去且下一帧已解码，跳过本帧追赶时钟
+	const double FrameSeconds = m_Clock.GetFrameSeconds(FrameDurationMs);
+	if (-Remaining >= FrameSeconds && m_FrameRing.Num() > 0)
+	{
+		m_Clock.OnDropped();
+		m_bHasPendingFrame = false;
+		return Now;
+	}
 
-				// 检查是否到达末尾 (读取失败或索引超限)
-				if (!bFrameReadSuccess || m_CurrentFrameIndex >= m_TotalFrames)
-				{
-					UE_LOG(LogTemp, Verbose, TEXT("非实时模式: 到达视频末尾 (读取 %s, Index %d >= %d)."),
-						bFrameReadSuccess ? TEXT("成功") : TEXT("失败"), m_CurrentFrameIndex, m_TotalFrames);
-
-					// --- 首次播放完成检测 ---
-					if (!m_bFirstPlayCompleted)
-					{
-						m_bFirstPlayCompleted = true;
-						NotifyFirstPlayCompleted();
-						UE_LOG(LogTemp, Log, TEXT("NotifyFirstPlayCompleted (非实时模式正向播放完成)"));
-					}
-					// --- 首次完成检测结束 ---
-
-					// 重置到开头实现循环播放
-					m_CurrentFrameIndex = 0;
-					m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-					UE_LOG(LogTemp, Verbose, TEXT("非实时模式: 重置索引为 0 以进行循环播放."));
-
-					// 尝试读取第一帧，否则画面会停留在最后一帧直到下一个时间间隔
-					if (m_WrapOpenCv->m_Stream.read(m_WrapOpenCv->m_Frame))
-					{
-						bFrameReadSuccess = true;
-						m_CurrentFrameIndex++; // 更新索引
-					}
-					else
-					{
-						// 如果连第一帧都读不了，可能视频有问题
-						UE_LOG(LogTemp, Error, TEXT("非实时模式: 循环后读取第一帧失败!"));
-						// 这里可以选择停止或继续尝试
-					}
-				}
-			} // 结束正向播放处理
+	Swap(m_PresentFrame, m_PendingFrame);
+	m_bHasPendingFrame = false;
+	m_Clock.OnPresented(m_PendingDueSeconds, Now, FrameSeconds);
 
-			// 4. 更新纹理 (如果读取成功)
-			if (bFrameReadSuccess)
-			{
-				NotifyFirstFrame(); // 通知首帧（如果尚未通知）
-				UpdateTexture();    // 更新纹理
-			}
-			else
-			{
-				// 读取失败（非循环点），可以记录日志或进行其他错误处理
-				UE_LOG(LogTemp, Warning, TEXT("非实时模式: 在帧 %d 处读取失败 (非循环点)."), m_CurrentFrameIndex);
-				// 可以考虑重试或停止
-			}
-
-		} // 结束 if (false == m_RealMode)
-		// --- 实时模式处理 (保持不变) ---
-		else
+	m_CurrentFrameIndex = m_PresentFrame.FrameIndex;
+	NotifyFirstFrame(); // 通知首帧（如果尚未通知）
+	TrackLoopHitch(FrameSeconds * 1000.0);
+	if (ShouldUpload(Now))
+	{
+		UpdateTexture();    // 更新纹理
+	}
+	// 立即取下一帧并计算它的显示时刻
+	return FPlatformTime::Seconds();
+}
+double VideoPlay::PrerollStep(double NowSeconds)
+{
+	m_bWasPreroll = true;
+	if (!m_bPrerollShown)
+	{
+		if (!PopFrame(m_PresentFrame))
 		{
-			FPlatformProcess::Sleep(m_SleepSecond / m_PlayRate);
+			return NowSeconds + PresentIdleSeconds;
+		}
+		m_bPrerollShown = true;
+		m_CurrentFrameIndex = m_PresentFrame.FrameIndex;
+	}
+	if (nullptr == m_BrushTexture)
+	{
+		// 纹理由游戏线程异步准备，准备好之前每次轮询重试上传首帧
+		UpdateTexture();
+	}
+	// 后续帧留在队列中，队列满后解码器等待，切换后立即可用
+	return NowSeconds + PresentIdleSeconds;
+}
+double VideoPlay::PresentLive(double NowSeconds)
+{
+	// 取空队列只显示最新一帧，积压的旧帧直接跳过
+	int32 Popped = 0;
+	while (PopFrame(m_PresentFrame))
+	{
+		++Popped;
+	}
 
-			if (true == m_WrapOpenCv->m_Stream.read(m_WrapOpenCv->m_Frame))
+	const double Now = FPlatformTime::Seconds();
+	if (Popped == 0)
+	{
+		// 画面长时间未更新视为断流，不可见节流期间帧间隔本来就长，不做判断
+		if (!m_bLiveStale && m_bVisible && (Now - m_LastLivePresentSeconds) * 1000.0 > m_LiveStaleThresholdMs)
+		{
 			{
-				NotifyFirstFrame();
-				UpdateTexture();
-				// 实时模式下也应该更新帧索引，虽然不直接用它来seek
-				m_CurrentFrameIndex = m_WrapOpenCv->m_Stream.get(cv::CAP_PROP_POS_FRAMES);
+				FScopeLock Lock(&m_StatsMutex);
+				m_bLiveStale = true;
 			}
-			else
-			{
-				// 实时模式读取失败，处理循环和完成通知
-				if (!m_bReverse) // 正向播放结束
-				{
-					if (!m_bFirstPlayCompleted)
-					{
-						m_bFirstPlayCompleted = true;
-						NotifyFirstPlayCompleted();
-						UE_LOG(LogTemp, Log, TEXT("NotifyFirstPlayCompleted (实时模式读取失败/结束)"));
-					}
-					// 实时模式循环
-					m_CurrentFrameIndex = 0;
-					m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-				}
-				else // 反向播放结束 (假设实时反向可行且会失败在开头)
-				{
-					// 处理反向循环和通知（如果需要）
-					m_CurrentFrameIndex = m_TotalFrames - 1;
-					m_WrapOpenCv->m_Stream.set(cv::CAP_PROP_POS_FRAMES, m_CurrentFrameIndex);
-				}
-			}
-		} // 结束 else (实时模式)
-	} // 结束 while (false == m_Stopping)
-
-	UE_LOG(LogTemp, Log, TEXT("VideoPlay Run 运行循环 结束"));
-	// 清理资源 (确保在循环外执行)
-	if (m_WrapOpenCv && m_WrapOpenCv->m_Stream.isOpened()) {
-		m_WrapOpenCv->m_Stream.release();
+			UE_LOG(LogTemp, Warning, TEXT("VideoPlay 直播画面 %.0f ms 未更新 url=%s"), (Now - m_LastLivePresentSeconds) * 1000.0, *m_VideoURL);
+			NotifyLiveStale();
+		}
+		// 新帧到达时由解码任务唤醒，否则到断流阈值时再检查
+		return m_bLiveStale ? Now + PresentIdleSeconds
+			: FMath::Min(Now + PresentIdleSeconds, m_LastLivePresentSeconds + m_LiveStaleThresholdMs / 1000.0);
 	}
-	// delete m_WrapOpenCv; // 不在这里delete，StopPlay会处理
-	// m_WrapOpenCv = nullptr;
 
-	return 0;
+	m_LastLivePresentSeconds = Now;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_LiveSkippedFrames += Popped - 1;
+	}
+	m_CurrentFrameIndex = m_PresentFrame.FrameIndex;
+	NotifyFirstFrame();
+	UpdateLiveLatency();
+	if (ShouldUpload(Now))
+	{
+		UpdateTexture();
+	}
+	return FPlatformTime::Seconds();
 }
-void VideoPlay::Exit()
+void VideoPlay::UpdateLiveLatency()
 {
+	const FInVideoFrame& Frame = m_PresentFrame;
+	const double Now = FPlatformTime::Seconds();
+	if (m_bResetLiveBaseline.Exchange(false))
+	{
+		m_LiveBaselineOffsetMs = TNumericLimits<double>::Max();
+	}
+	double LatencyMs = 0.0;
+	const bool bAbsolute = Frame.CaptureEpochMs > 0.0;
+	if (bAbsolute)
+	{
+		// 源提供采集时刻的绝对时间，直接与本机 UTC 时间相减（依赖两端时钟同步）
+		const double UtcNowMs = (FDateTime::UtcNow() - FDateTime(1970, 1, 1)).GetTotalMilliseconds();
+		LatencyMs = UtcNowMs - Frame.CaptureEpochMs;
+	}
+	else
+	{
+		// 以 (解码时刻 - PTS) 的会话最小值为基线，估计网络和缓冲带来的额外延迟，再加上解码到显示的耗时
+		const double OffsetMs = Frame.DecodedSeconds * 1000.0 - Frame.PtsMs;
+		m_LiveBaselineOffsetMs = FMath::Min(m_LiveBaselineOffsetMs, OffsetMs);
+		LatencyMs = OffsetMs - m_LiveBaselineOffsetMs + (Now - Frame.DecodedSeconds) * 1000.0;
+	}
 
+	const bool bStale = LatencyMs > m_LiveStaleThresholdMs;
+	bool bBecameStale = false;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_LiveLatencyMs = (float)LatencyMs;
+		m_bLiveLatencyAbsolute = bAbsolute;
+		bBecameStale = bStale && !m_bLiveStale;
+		m_bLiveStale = bStale;
+	}
+	if (bBecameStale)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("VideoPlay 直播延迟 %.0f ms 超过阈值 url=%s"), LatencyMs, *m_VideoURL);
+		NotifyLiveStale();
+	}
 }
-void VideoPlay::Stop()
+void VideoPlay::TrackLoopHitch(double TargetIntervalMs)
 {
-
+	const double Now = FPlatformTime::Seconds();
+	const int32 FrameIndex = m_PresentFrame.FrameIndex;
+	// 正向播放从较大的帧号回到第 0 帧视为一次回绕
+	if (FrameIndex == 0 && m_LastPresentedIndex > 0 && !m_bReverse)
+	{
+		const float HitchMs = (float)FMath::Max(0.0, (Now - m_LastPresentSeconds) * 1000.0 - TargetIntervalMs);
+		{
+			FScopeLock Lock(&m_StatsMutex);
+			++m_LoopCount;
+			m_LastLoopHitchMs = HitchMs;
+			m_MaxLoopHitchMs = FMath::Max(m_MaxLoopHitchMs, HitchMs);
+		}
+		INC_DWORD_STAT(STAT_InVideo_LoopCount);
+		SET_FLOAT_STAT(STAT_InVideo_LoopHitchMs, HitchMs);
+		UE_LOG(LogTemp, Verbose, TEXT("VideoPlay 循环回绕 卡顿 %.2f ms"), HitchMs);
+	}
+	m_LastPresentedIndex = FrameIndex;
+	m_LastPresentSeconds = Now;
 }
 void VideoPlay::NotifyFailed()
 {
@@ -621,6 +1245,10 @@ void VideoPlay::NotifyFirstFrame()
 		return;
 	}
 	m_BFirstFrame = true;
+	{
+		FScopeLock Lock(&m_StatsMutex);
+		m_FirstFrameLatencyMs = (float)((FPlatformTime::Seconds() - m_StartSeconds) * 1000.0);
+	}
 	AsyncTask(ENamedThreads::GameThread, [FirstFrame = m_FirstFrame]()
 		{
 			if (FirstFrame.IsBound())
@@ -630,157 +1258,137 @@ void VideoPlay::NotifyFirstFrame()
 
 void VideoPlay::UpdateTexture()
 {
-	// 1. 使用双缓冲避免每帧分配内存
-	static TArray<uint8> PixelBuffer1, PixelBuffer2;
-	static TArray<uint8>* CurrentBuffer = &PixelBuffer1;
-	static TArray<uint8>* NextBuffer = &PixelBuffer2;
+	// 1. 从本实例的上传缓冲池取一块缓冲区，渲染命令消费完之前不会被复用
+	FUploadBufferPool::FBufferRef UploadBuffer = m_UploadBufferPool->Acquire();
+	if (!UploadBuffer.IsValid())
+	{
+		// 所有缓冲区都还在渲染线程排队，跳过本帧上传而不是覆盖正在使用的内存
+		UE_LOG(LogTemp, Verbose, TEXT("VideoPlay UpdateTexture 上传缓冲区耗尽, 跳过帧 %d"), m_CurrentFrameIndex);
+		return;
+	}
+
+	// 原生平面上传，颜色转换和缩放在着色器中完成
+	if (m_UploadMode == EInVideoUploadMode::Native)
+	{
+		UpdatePlanes(MoveTemp(UploadBuffer));
+		return;
+	}
 
 	// 2. 得到最终用于渲染的 Mat —— resizedFrame
+	// 解码阶段已按目标尺寸缩放，这里只处理设置分辨率之前已入队的帧，结果 Mat 跨帧复用
 	cv::Mat resizedFrame;
-	if (m_bCustomResolution)
+	if (m_bCustomResolution && (m_PresentFrame.Image.cols != (int32)m_TargetResolution.X || m_PresentFrame.Image.rows != (int32)m_TargetResolution.Y))
 	{
-		cv::resize(m_WrapOpenCv->m_Frame, resizedFrame,
-			cv::Size(m_TargetResolution.X, m_TargetResolution.Y));
+		cv::resize(m_PresentFrame.Image, m_ResizedFrame,
+			cv::Size(m_TargetResolution.X, m_TargetResolution.Y), 0, 0, cv::INTER_AREA);
+		resizedFrame = m_ResizedFrame;
 	}
 	else
 	{
-		resizedFrame = m_WrapOpenCv->m_Frame;
+		resizedFrame = m_PresentFrame.Image;
 	}
 
 	// 3. 用 resizedFrame 的实际大小后续全部使用
 	const int32 NewWidth = resizedFrame.cols;
 	const int32 NewHeight = resizedFrame.rows;
 
-	// 4. 判断是否需要重建纹理资源
-	if (VideoTexture == nullptr
-		|| m_VideoSize.X != NewWidth
-		|| m_VideoSize.Y != NewHeight)
-	{
-		// 更新记录的当前视频大小
-		m_VideoSize = FVector2D(NewWidth, NewHeight);
-
-		// 在GameThread里创建或重置纹理
-		FEvent* SyncEvent = FGenericPlatformProcess::GetSynchEventFromPool(false);
-		AsyncTask(ENamedThreads::GameThread, [this, SyncEvent]()
-			{
-				VideoTexture = UTexture2D::CreateTransient(m_VideoSize.X, m_VideoSize.Y);
-				if (VideoTexture)
-				{
-					VideoTexture->Filter = TF_Bilinear;
-					VideoTexture->SRGB = true;
-					VideoTexture->CompressionSettings = TC_Default;
-					VideoTexture->UpdateResource();
-					VideoTexture->AddToRoot();  // 防止被GC
-				}
-				m_Texture2DResource = (FTexture2DResource*)VideoTexture->GetResource();
-				SyncEvent->Trigger();
-			});
-		SyncEvent->Wait();
-		FGenericPlatformProcess::ReturnSynchEventToPool(SyncEvent);
-
-		// 重建 UpdateTextureRegion
-		if (m_VideoUpdateTextureRegion)
-		{
-			delete m_VideoUpdateTextureRegion;
-			m_VideoUpdateTextureRegion = nullptr;
-		}
-		m_VideoUpdateTextureRegion = new FUpdateTextureRegion2D(
-			0, 0, 0, 0,
-			NewWidth, NewHeight
-		);
-
-		// 预分配一次，避免频繁分配
-		if (m_PixelDataBuffer.Num() < NewWidth * NewHeight * 4) {
-			m_PixelDataBuffer.SetNumUninitialized(NewWidth * NewHeight * 4);
-		}
-	}
+	// mip 级数不超过最短边能减半的次数
+	const int32 NumMips = FMath::Min(m_TextureMipCount, (int32)FMath::FloorLog2((uint32)FMath::Min(NewWidth, NewHeight)) + 1);
 
-	// 如果依然没有 Texture，说明可能初始化失败，直接返回
-	if (!VideoTexture)
+	// 4. 从视频表面取与当前尺寸档位匹配的纹理，尺寸变化时由游戏线程异步准备，准备好之前跳过上传
+	const FInVideoSurface::FView Surface = m_Surface->Resolve(FIntPoint(NewWidth, NewHeight), NumMips);
+	if (!Surface.IsValid())
 	{
+		FScopeLock Lock(&m_StatsMutex);
+		++m_SurfacePendingFrames;
 		return;
 	}
 
-	// 5. 填充像素数据 (BGR => RGBA)
-	FColor* PixelData = reinterpret_cast<FColor*>(m_PixelDataBuffer.GetData());
+	// 5. 填充像素数据 (BGR => RGBA)，各级 mip 依次排列在同一块缓冲区，缓冲区循环复用，只在尺寸变大时分配
+	int64 UploadBytes = 0;
+	for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+	{
+		UploadBytes += (int64)FMath::Max(1, NewWidth >> MipIndex) * FMath::Max(1, NewHeight >> MipIndex) * 4;
+	}
+	UploadBuffer->SetNumUninitialized((int32)UploadBytes, false);
+	FColor* PixelData = reinterpret_cast<FColor*>(UploadBuffer->GetData());
 
-	// 使用并行处理加速像素转换
-	ParallelFor(NewHeight, [&](int32 y) {
-		for (int x = 0; x < NewWidth; x++)
-		{
-			int32 i = x + y * NewWidth;
-			int32 srcIdx = i * 3;
-			PixelData[i].B = resizedFrame.data[srcIdx];
-			PixelData[i].G = resizedFrame.data[srcIdx + 1];
-			PixelData[i].R = resizedFrame.data[srcIdx + 2];
-			PixelData[i].A = 255;
-		}
-		});
+	// 向量化内核按行块并行转换
+	InVideoPixelConvert::BGRToBGRAImage(resizedFrame.data, (int32)resizedFrame.step,
+		reinterpret_cast<uint8*>(PixelData), NewWidth * 4, NewWidth, NewHeight);
 
-	// 6. 更新纹理区域
-	UpdateTextureRegions(VideoTexture, 0, 1, m_VideoUpdateTextureRegion,
-		(uint32)(4 * NewWidth), (uint32)4, (uint8*)PixelData, false);
+	// 6. 每级 mip 由上一级 2x2 盒式下采样得到
+	uint8* MipData = UploadBuffer->GetData();
+	for (int32 MipIndex = 1; MipIndex < NumMips; ++MipIndex)
+	{
+		const int32 SrcWidth = FMath::Max(1, NewWidth >> (MipIndex - 1));
+		const int32 SrcHeight = FMath::Max(1, NewHeight >> (MipIndex - 1));
+		uint8* NextMipData = MipData + (int64)SrcWidth * SrcHeight * 4;
+		InVideoPixelConvert::DownsampleBGRA2x2(MipData, SrcWidth * 4, SrcWidth, SrcHeight,
+			NextMipData, FMath::Max(1, NewWidth >> MipIndex) * 4);
+		MipData = NextMipData;
+	}
 
-	// 7. 在Game Thread中设置 UImage 的 Brush
-	AsyncTask(ENamedThreads::GameThread, [vt = VideoTexture, widget = m_widget]()
-		{
-			if (!widget.IsValid() || !vt->IsValidLowLevel() || !widget->ImageVideo)
-			{
-				return;
-			}
-			widget->ImageVideo->SetBrushFromTexture(vt);
-		});
+	// 7. 交给上传调度，本帧结束时与其他播放器的上传合并为一条渲染命令
+	FInVideoUpload Upload;
+	Upload.Texture = (FTexture2DResource*)Surface.Resource;
+	Upload.NumMips = NumMips;
+	Upload.Width = NewWidth;
+	Upload.Height = NewHeight;
+	Upload.Buffer = MoveTemp(UploadBuffer);
+	SubmitUpload(MoveTemp(Upload));
+
+	// 8. 纹理换了才设置 UImage 的 Brush，纹理大于帧时只显示帧所在的区域
+	UpdateBrush(Surface.Texture, Surface.GetUVRegion(FIntPoint(NewWidth, NewHeight)));
 }
-void VideoPlay::UpdateTextureRegions(UTexture2D* Texture, int32 MipIndex, uint32 NumRegions, FUpdateTextureRegion2D* Regions, uint32 SrcPitch, uint32 SrcBpp, uint8* SrcData, bool bFreeData)
+void VideoPlay::UpdatePlanes(FUploadBufferPool::FBufferRef UploadBuffer)
 {
-	if (m_Texture2DResource)
+	const FInVideoFrame& Frame = m_PresentFrame;
+	const FIntPoint OutputSize = m_bCustomResolution
+		? FIntPoint(m_TargetResolution.X, m_TargetResolution.Y)
+		: FIntPoint(Frame.Width, Frame.Height);
+
+	// 1. 从视频表面取输出尺寸的渲染目标，尺寸变化时由游戏线程异步准备，准备好之前跳过上传
+	const FInVideoSurface::FView Surface = m_Surface->Resolve(OutputSize, 1);
+	if (!Surface.IsValid())
 	{
-		struct FUpdateTextureRegionsData
-		{
-			FTexture2DResource* Texture2DResource;
-			int32 MipIndex;
-			uint32 NumRegions;
-			FUpdateTextureRegion2D* Regions;
-			uint32 SrcPitch;
-			uint32 SrcBpp;
-			uint8* SrcData;
-		};
-		FUpdateTextureRegionsData* RegionData = new FUpdateTextureRegionsData;
-
-		RegionData->Texture2DResource = m_Texture2DResource;
-		RegionData->MipIndex = MipIndex;
-		RegionData->NumRegions = NumRegions;
-		RegionData->Regions = new FUpdateTextureRegion2D(*Regions);
-		RegionData->SrcPitch = SrcPitch;
-		RegionData->SrcBpp = SrcBpp;
-		RegionData->SrcData = SrcData;
-
-		ENQUEUE_RENDER_COMMAND(UpdateTextureRegionsData)([RegionData, bFreeData](FRHICommandListImmediate& RHICmdList) {
-
-			for (uint32 RegionIndex = 0; RegionIndex < RegionData->NumRegions; ++RegionIndex)
-			{
-				int32 CurrentFirstMip = RegionData->Texture2DResource->GetCurrentFirstMip();
-				if (RegionData->MipIndex >= CurrentFirstMip)
-				{
-					RHIUpdateTexture2D(
-						RegionData->Texture2DResource->GetTexture2DRHI(),
-						RegionData->MipIndex - CurrentFirstMip,
-						RegionData->Regions[RegionIndex],
-						RegionData->SrcPitch,
-						RegionData->SrcData
-						+ RegionData->Regions[RegionIndex].SrcY * RegionData->SrcPitch
-						+ RegionData->Regions[RegionIndex].SrcX * RegionData->SrcBpp
-					);
-				}
-			}
-			if (bFreeData)
-			{
-				//FMemory::Free(RegionData->Regions);
-				//FMemory::Free(RegionData->SrcData);
+		FScopeLock Lock(&m_StatsMutex);
+		++m_SurfacePendingFrames;
+		return;
+	}
 
-			}
-			delete RegionData->Regions;
-			delete RegionData;
-			});
+	// 2. 按平面布局紧凑拷贝到上传缓冲区（YUV420 每像素 1.5 字节，BGR 3 字节）
+	// 帧的数据少于布局需要的字节数时丢弃，不越界读取
+	const int64 FrameBytes = InVideoPlanes::GetFrameBytes(Frame.Layout, Frame.Width, Frame.Height);
+	if (!InVideoPlanes::IsFrameComplete(Frame.Layout, Frame.Width, Frame.Height, (int64)Frame.Image.total() * Frame.Image.elemSize()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("VideoPlay 帧数据不完整 %dx%d, 跳过上传"), Frame.Width, Frame.Height);
+		return;
+	}
+	UploadBuffer->SetNumUninitialized(FrameBytes, false);
+	if (Frame.Image.isContinuous())
+	{
+		FMemory::Memcpy(UploadBuffer->GetData(), Frame.Image.data, FrameBytes);
 	}
+	else
+	{
+		const int64 RowBytes = Frame.Image.cols * Frame.Image.elemSize();
+		for (int64 y = 0, Copied = 0; y < Frame.Image.rows && Copied < FrameBytes; ++y, Copied += RowBytes)
+		{
+			FMemory::Memcpy(UploadBuffer->GetData() + Copied, Frame.Image.ptr(y), FMath::Min(RowBytes, FrameBytes - Copied));
+		}
+	}
+
+	// 3. 渲染线程上传平面并转换到渲染目标
+	FInVideoUpload Upload;
+	Upload.Planes = m_PlaneTextures;
+	Upload.Target = (FTextureRenderTargetResource*)Surface.Resource;
+	Upload.Layout = Frame.Layout;
+	Upload.Width = Frame.Width;
+	Upload.Height = Frame.Height;
+	Upload.Buffer = MoveTemp(UploadBuffer);
+	SubmitUpload(MoveTemp(Upload));
+
+	// 4. 渲染目标换了才设置 UImage 的 Brush
+	UpdateBrush(Surface.Texture, Surface.GetUVRegion(OutputSize));
 }
\ No newline at end of file
@@ -0,0 +1,393 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InVideoWorkerPool.h"
+#include "InVideoStats.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	TAutoConsoleVariable<int32> CVarInVideoWorkerThreads(
+		TEXT("InVideo.WorkerThreads"),
+		0,
+		TEXT("InVideo 解码/显示工作线程数，0 表示按 CPU 核数自动选择。首次播放前设置有效"),
+		ECVF_Default);
+
+	TAutoConsoleVariable<int32> CVarInVideoIOThreads(
+		TEXT("InVideo.IOThreads"),
+		0,
+		TEXT("InVideo 网络流/采集卡 I/O 线程数，0 表示按 CPU 核数自动选择。第一个网络流打开前设置有效"),
+		ECVF_Default);
+
+	FCriticalSection GPoolMutex;
+	TUniquePtr<FInVideoWorkerPool> GPool;
+
+	// 等到 DueSeconds 或被事件唤醒；没有到期时刻时只等事件
+	void WaitUntil(FEvent* Event, double DueSeconds)
+	{
+		if (DueSeconds >= TNumericLimits<double>::Max())
+		{
+			Event->Wait();
+			return;
+		}
+		const double WaitSeconds = DueSeconds - FPlatformTime::Seconds();
+		if (WaitSeconds >= 0.001)
+		{
+			Event->Wait(FTimespan::FromSeconds(WaitSeconds));
+		}
+		else if (WaitSeconds > 0.0)
+		{
+			// 不足 1ms 时让出时间片，保证显示时刻的精度
+			FPlatformProcess::YieldThread();
+		}
+	}
+}
+
+FInVideoWorkerPool& FInVideoWorkerPool::Get()
+{
+	FScopeLock Lock(&GPoolMutex);
+	if (!GPool.IsValid())
+	{
+		int32 NumWorkers = CVarInVideoWorkerThreads.GetValueOnAnyThread();
+		if (NumWorkers <= 0)
+		{
+			// 留一个核给游戏线程和渲染线程
+			NumWorkers = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 2, 2, 16);
+		}
+		GPool.Reset(new FInVideoWorkerPool(NumWorkers));
+	}
+	return *GPool;
+}
+
+void FInVideoWorkerPool::Shutdown()
+{
+	FScopeLock Lock(&GPoolMutex);
+	GPool.Reset();
+}
+
+FInVideoWorkerPool::FInVideoWorkerPool(int32 NumWorkers)
+{
+	UE_LOG(LogTemp, Log, TEXT("FInVideoWorkerPool 创建 %d 个工作线程"), NumWorkers);
+	StartGroup(EGroup::Compute, NumWorkers, TEXT("InVideo Worker"));
+}
+
+FInVideoWorkerPool::~FInVideoWorkerPool()
+{
+	for (FWorkerGroup& Group : m_Groups)
+	{
+		for (TUniquePtr<FWorker>& Worker : Group.Workers)
+		{
+			Worker->Stop();
+		}
+	}
+	for (FWorkerGroup& Group : m_Groups)
+	{
+		Group.Workers.Reset();
+	}
+}
+
+void FInVideoWorkerPool::StartGroup(EGroup Group, int32 NumWorkers, const TCHAR* ThreadName)
+{
+	FWorkerGroup& WorkerGroup = m_Groups[(int32)Group];
+	for (int32 i = 0; i < NumWorkers; ++i)
+	{
+		WorkerGroup.Workers.Add(MakeUnique<FWorker>(*this, WorkerGroup, i));
+	}
+	for (TUniquePtr<FWorker>& Worker : WorkerGroup.Workers)
+	{
+		Worker->Thread = FRunnableThread::Create(Worker.Get(), *FString::Printf(TEXT("%s %d"), ThreadName, Worker->Index));
+	}
+}
+
+FInVideoWorkerPool::FTaskHandle FInVideoWorkerPool::Register(const FString& Name, FTickFunction Tick)
+{
+	return RegisterIn(EGroup::Compute, Name, MoveTemp(Tick));
+}
+
+FInVideoWorkerPool::FTaskHandle FInVideoWorkerPool::RegisterBlocking(const FString& Name, FTickFunction Tick)
+{
+	if (!m_bIOGroupStarted)
+	{
+		FScopeLock Lock(&m_IOGroupMutex);
+		if (!m_bIOGroupStarted)
+		{
+			int32 NumWorkers = CVarInVideoIOThreads.GetValueOnAnyThread();
+			if (NumWorkers <= 0)
+			{
+				// grab 同时负责解码，按核数而不是流数分配；线程大多阻塞在网络上，下限放宽一些
+				NumWorkers = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 4, 16);
+			}
+			UE_LOG(LogTemp, Log, TEXT("FInVideoWorkerPool 创建 %d 个 I/O 线程"), NumWorkers);
+			StartGroup(EGroup::BlockingIO, NumWorkers, TEXT("InVideo IO"));
+			m_bIOGroupStarted = true;
+		}
+	}
+	return RegisterIn(EGroup::BlockingIO, Name, MoveTemp(Tick));
+}
+
+FInVideoWorkerPool::FTaskHandle FInVideoWorkerPool::RegisterIn(EGroup Group, const FString& Name, FTickFunction Tick)
+{
+	FTaskHandle Task = MakeShared<FTask, ESPMode::ThreadSafe>();
+	Task->Name = Name;
+	Task->Tick = MoveTemp(Tick);
+	Task->Group = Group;
+	Task->DueSeconds = FPlatformTime::Seconds();
+
+	// 新任务轮流分配到组内各线程，之后由窃取自动均衡
+	FWorkerGroup& WorkerGroup = m_Groups[(int32)Group];
+	const int32 WorkerIndex = (WorkerGroup.NextWorker++) % WorkerGroup.Workers.Num();
+	FWorker& Worker = *WorkerGroup.Workers[WorkerIndex];
+	{
+		FScopeLock Lock(&Worker.Mutex);
+		Task->OwnerWorker = WorkerIndex;
+		Worker.Tasks.Add(Task);
+	}
+	Worker.WakeEvent->Trigger();
+	if (Worker.bBusy)
+	{
+		WakeIdleWorker(WorkerGroup, WorkerIndex);
+	}
+	return Task;
+}
+
+void FInVideoWorkerPool::Unregister(const FTaskHandle& Task)
+{
+	if (!Task.IsValid())
+	{
+		return;
+	}
+	Task->bRemoved = true;
+	RemoveFromWorker(Task);
+
+	// 在任务自己的 Tick 里注销时不能等待自己；I/O 任务正在阻塞时最多等到它自身的超时
+	if (Task->RunningThreadId == FPlatformTLS::GetCurrentThreadId())
+	{
+		return;
+	}
+	while (Task->bRunning)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+void FInVideoWorkerPool::Wake(const FTaskHandle& Task)
+{
+	if (!Task.IsValid() || Task->bRemoved)
+	{
+		return;
+	}
+	Task->bWakeRequested = true;
+	Task->DueSeconds = FPlatformTime::Seconds();
+
+	// 任务可能刚被窃取到别的线程：在所属线程的锁内确认归属后再触发它的事件
+	FWorkerGroup& Group = m_Groups[(int32)Task->Group];
+	for (;;)
+	{
+		const int32 WorkerIndex = Task->OwnerWorker;
+		if (!Group.Workers.IsValidIndex(WorkerIndex))
+		{
+			return;
+		}
+		FWorker& Worker = *Group.Workers[WorkerIndex];
+		bool bOwnerBusy = false;
+		{
+			FScopeLock Lock(&Worker.Mutex);
+			if (Task->OwnerWorker != WorkerIndex)
+			{
+				continue;
+			}
+			Worker.WakeEvent->Trigger();
+			bOwnerBusy = Worker.bBusy;
+		}
+		if (bOwnerBusy)
+		{
+			WakeIdleWorker(Group, WorkerIndex);
+		}
+		return;
+	}
+}
+
+void FInVideoWorkerPool::WakeIdleWorker(FWorkerGroup& Group, int32 BusyIndex)
+{
+	const int32 NumWorkers = Group.Workers.Num();
+	for (int32 Offset = 1; Offset < NumWorkers; ++Offset)
+	{
+		FWorker& Worker = *Group.Workers[(BusyIndex + Offset) % NumWorkers];
+		if (!Worker.bBusy)
+		{
+			Worker.WakeEvent->Trigger();
+			return;
+		}
+	}
+}
+
+void FInVideoWorkerPool::RemoveFromWorker(const FTaskHandle& Task)
+{
+	// 任务可能正被窃取到同组别的线程，逐个队列查找
+	for (TUniquePtr<FWorker>& Worker : m_Groups[(int32)Task->Group].Workers)
+	{
+		FScopeLock Lock(&Worker->Mutex);
+		if (Worker->Tasks.Remove(Task) > 0)
+		{
+			return;
+		}
+	}
+}
+
+FInVideoWorkerPool::FTaskHandle FInVideoWorkerPool::ClaimOwn(FWorker& Worker, double NowSeconds, double& OutEarliestDue)
+{
+	FScopeLock Lock(&Worker.Mutex);
+	FTaskHandle Best;
+	double BestDue = TNumericLimits<double>::Max();
+	for (const FTaskHandle& Task : Worker.Tasks)
+	{
+		const double Due = Task->DueSeconds;
+		if (!Task->bRunning && Due < BestDue)
+		{
+			Best = Task;
+			BestDue = Due;
+		}
+	}
+	OutEarliestDue = BestDue;
+	if (Best.IsValid() && BestDue <= NowSeconds)
+	{
+		Best->bRunning = true;
+		return Best;
+	}
+	return nullptr;
+}
+
+FInVideoWorkerPool::FTaskHandle FInVideoWorkerPool::Steal(FWorker& Worker, double NowSeconds, double& OutEarliestStealable)
+{
+	OutEarliestStealable = TNumericLimits<double>::Max();
+	const int32 NumWorkers = Worker.Group.Workers.Num();
+	for (int32 Offset = 1; Offset < NumWorkers; ++Offset)
+	{
+		FWorker& Victim = *Worker.Group.Workers[(Worker.Index + Offset) % NumWorkers];
+		FTaskHandle Stolen;
+		{
+			FScopeLock Lock(&Victim.Mutex);
+			// 只偷最早到期的那个，且对方正忙时才偷（对方空闲会自己执行）
+			if (!Victim.bBusy)
+			{
+				continue;
+			}
+			double BestDue = TNumericLimits<double>::Max();
+			int32 BestIndex = INDEX_NONE;
+			for (int32 i = 0; i < Victim.Tasks.Num(); ++i)
+			{
+				const FTaskHandle& Task = Victim.Tasks[i];
+				const double Due = Task->DueSeconds;
+				if (!Task->bRunning && Due < BestDue)
+				{
+					BestDue = Due;
+					BestIndex = i;
+				}
+			}
+			if (BestIndex != INDEX_NONE && BestDue > NowSeconds)
+			{
+				// 还没到期：记下时刻，空闲线程等到那时再来窃取
+				OutEarliestStealable = FMath::Min(OutEarliestStealable, BestDue);
+			}
+			else if (BestIndex != INDEX_NONE)
+			{
+				Stolen = Victim.Tasks[BestIndex];
+				Victim.Tasks.RemoveAtSwap(BestIndex);
+				Stolen->bRunning = true;
+			}
+		}
+		if (Stolen.IsValid())
+		{
+			FScopeLock Lock(&Worker.Mutex);
+			Stolen->OwnerWorker = Worker.Index;
+			Worker.Tasks.Add(Stolen);
+			return Stolen;
+		}
+	}
+	return nullptr;
+}
+
+void FInVideoWorkerPool::Execute(const FTaskHandle& Task, double NowSeconds)
+{
+	double NextDue = -1.0;
+	// 之前的唤醒已体现在到期时刻里，只关心 Tick 期间到来的唤醒
+	Task->bWakeRequested = false;
+	if (!Task->bRemoved)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_InVideo_WorkerTick);
+		Task->RunningThreadId = FPlatformTLS::GetCurrentThreadId();
+		NextDue = Task->Tick(NowSeconds);
+		Task->RunningThreadId = 0;
+	}
+
+	if (NextDue < 0.0 || Task->bRemoved)
+	{
+		Task->bRemoved = true;
+		RemoveFromWorker(Task);
+	}
+	else
+	{
+		// 先写回返回值再检查唤醒：Tick 期间或写回前到来的唤醒都不会被覆盖
+		Task->DueSeconds = NextDue;
+		if (Task->bWakeRequested.Exchange(false))
+		{
+			Task->DueSeconds = FPlatformTime::Seconds();
+		}
+	}
+	Task->bRunning = false;
+}
+
+FInVideoWorkerPool::FWorker::FWorker(FInVideoWorkerPool& InPool, FWorkerGroup& InGroup, int32 InIndex)
+	: Pool(InPool)
+	, Group(InGroup)
+	, Index(InIndex)
+{
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+}
+
+FInVideoWorkerPool::FWorker::~FWorker()
+{
+	if (nullptr != Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+uint32 FInVideoWorkerPool::FWorker::Run()
+{
+	while (false == bStopping)
+	{
+		const double Now = FPlatformTime::Seconds();
+		double EarliestDue = TNumericLimits<double>::Max();
+		double EarliestStealable = TNumericLimits<double>::Max();
+		FTaskHandle Task = Pool.ClaimOwn(*this, Now, EarliestDue);
+		if (!Task.IsValid())
+		{
+			Task = Pool.Steal(*this, Now, EarliestStealable);
+		}
+		if (Task.IsValid())
+		{
+			bBusy = true;
+			Pool.Execute(Task, Now);
+			bBusy = false;
+			continue;
+		}
+
+		// 等到本队列或忙碌线程上最早的到期时刻；被 Wake/Register 提前唤醒
+		WaitUntil(WakeEvent, FMath::Min(EarliestDue, EarliestStealable));
+	}
+	return 0;
+}
+
+void FInVideoWorkerPool::FWorker::Stop()
+{
+	bStopping = true;
+	WakeEvent->Trigger();
+}
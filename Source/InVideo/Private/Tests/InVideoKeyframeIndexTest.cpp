@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "InVideoKeyframeIndex.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include "PostOpenCVHeaders.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// 帧号按位写成黑白竖条，有损编码后仍能按块均值读回
+	constexpr int32 ClipBits = 8;
+	constexpr int32 ClipBlockWidth = 16;
+	constexpr int32 ClipHeight = 32;
+	constexpr int32 ClipFrames = 60;
+
+	void DrawFrameIndex(cv::Mat& Image, int32 FrameIndex)
+	{
+		for (int32 Bit = 0; Bit < ClipBits; ++Bit)
+		{
+			const uint8 Level = (FrameIndex >> Bit) & 1 ? 255 : 0;
+			Image(cv::Rect(Bit * ClipBlockWidth, 0, ClipBlockWidth, ClipHeight)).setTo(cv::Scalar(Level, Level, Level));
+		}
+	}
+
+	int32 ReadFrameIndex(const cv::Mat& Image)
+	{
+		int32 FrameIndex = 0;
+		for (int32 Bit = 0; Bit < ClipBits; ++Bit)
+		{
+			// 只取块中心，避开块边缘的压缩振铃
+			const cv::Rect Center(Bit * ClipBlockWidth + 4, 8, ClipBlockWidth - 8, ClipHeight - 16);
+			if (cv::mean(Image(Center))[0] > 128.0)
+			{
+				FrameIndex |= 1 << Bit;
+			}
+		}
+		return FrameIndex;
+	}
+
+	// 优先用带 GOP 的编码，后端不支持时退回全关键帧的 MJPG
+	bool WriteClip(const FString& Path)
+	{
+		const cv::Size Size(ClipBits * ClipBlockWidth, ClipHeight);
+		cv::VideoWriter Writer;
+		if (!Writer.open(TCHAR_TO_UTF8(*Path), cv::CAP_FFMPEG, cv::VideoWriter::fourcc('m', 'p', '4', 'v'), 25.0, Size)
+			&& !Writer.open(TCHAR_TO_UTF8(*Path), cv::CAP_FFMPEG, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 25.0, Size))
+		{
+			return false;
+		}
+		cv::Mat Image(Size, CV_8UC3);
+		for (int32 FrameIndex = 0; FrameIndex < ClipFrames; ++FrameIndex)
+		{
+			DrawFrameIndex(Image, FrameIndex);
+			Writer.write(Image);
+		}
+		Writer.release();
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInVideoKeyframeSeekTest, "InVideo.KeyframeIndex.Seek",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInVideoKeyframeSeekTest::RunTest(const FString& Parameters)
+{
+	const FString ClipPath = FPaths::ConvertRelativePathToFull(
+		FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("InVideo"), TEXT("KeyframeSeek.avi")));
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(ClipPath), true);
+	if (!WriteClip(ClipPath))
+	{
+		AddError(TEXT("无法生成测试视频，OpenCV 的 FFmpeg 后端不可用"));
+		return false;
+	}
+
+	TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> Index = FInVideoKeyframeIndex::LoadOrBuild(ClipPath);
+	if (!TestTrue(TEXT("扫描生成索引"), Index.IsValid()))
+	{
+		IFileManager::Get().Delete(*ClipPath);
+		return false;
+	}
+	TestEqual(TEXT("总帧数"), Index->GetTotalFrames(), ClipFrames);
+	TestEqual(TEXT("第一个关键帧"), Index->GetKeyframeFrames()[0], 0);
+
+	// 第二次从缓存加载，结果与扫描一致
+	TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> Cached = FInVideoKeyframeIndex::LoadOrBuild(ClipPath);
+	if (TestTrue(TEXT("加载缓存"), Cached.IsValid()))
+	{
+		TestTrue(TEXT("缓存的关键帧与扫描一致"), Cached->GetKeyframeFrames() == Index->GetKeyframeFrames());
+	}
+
+	// 与解码器的 Seek 相同：定位到不晚于目标的关键帧，再顺序 grab 到目标帧
+	cv::VideoCapture Stream;
+	if (TestTrue(TEXT("打开测试视频"), Stream.open(TCHAR_TO_UTF8(*ClipPath), cv::CAP_FFMPEG)))
+	{
+		const int32 Targets[] = { 0, 1, 11, 12, 13, 30, 47, ClipFrames - 1, 5 };
+		cv::Mat Image;
+		for (const int32 Target : Targets)
+		{
+			const int32 Keyframe = Index->GetKeyframeAtOrBefore(Target);
+			TestTrue(FString::Printf(TEXT("帧 %d 的关键帧不晚于目标"), Target), Keyframe <= Target);
+			Stream.set(cv::CAP_PROP_POS_FRAMES, Keyframe);
+			for (int32 i = Keyframe; i < Target; ++i)
+			{
+				Stream.grab();
+			}
+			if (TestTrue(FString::Printf(TEXT("读取帧 %d"), Target), Stream.read(Image)))
+			{
+				TestEqual(FString::Printf(TEXT("Seek 到帧 %d"), Target), ReadFrameIndex(Image), Target);
+			}
+		}
+		Stream.release();
+	}
+
+	IFileManager::Get().Delete(*ClipPath);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "InVideoPlaneUpload.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include "PostOpenCVHeaders.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInVideoPlaneLayoutTest, "InVideo.PlaneUpload.PlaneLayout",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInVideoPlaneLayoutTest::RunTest(const FString& Parameters)
+{
+	FInVideoPlaneDescArray Planes;
+
+	// 偶数尺寸 I420：Y 后紧接 U、V，各为四分之一面积
+	InVideoPlanes::GetPlaneLayout(EInVideoPlaneLayout::I420, 1920, 1080, Planes);
+	if (TestEqual(TEXT("I420 平面数"), Planes.Num(), 3))
+	{
+		TestEqual(TEXT("I420 U 宽"), Planes[1].Width, 960);
+		TestEqual(TEXT("I420 U 高"), Planes[1].Height, 540);
+		TestEqual(TEXT("I420 U 偏移"), Planes[1].Offset, (int64)1920 * 1080);
+		TestEqual(TEXT("I420 V 偏移"), Planes[2].Offset, (int64)1920 * 1080 + 960 * 540);
+	}
+	TestEqual(TEXT("I420 1080p 字节数"), InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::I420, 1920, 1080), (int64)1920 * 1080 * 3 / 2);
+
+	// 奇数尺寸：色度向上取整，5x3 的色度平面为 3x2
+	InVideoPlanes::GetPlaneLayout(EInVideoPlaneLayout::I420, 5, 3, Planes);
+	if (TestEqual(TEXT("I420 奇数尺寸平面数"), Planes.Num(), 3))
+	{
+		TestEqual(TEXT("I420 奇数尺寸 U 宽"), Planes[1].Width, 3);
+		TestEqual(TEXT("I420 奇数尺寸 U 高"), Planes[1].Height, 2);
+		TestEqual(TEXT("I420 奇数尺寸 V 偏移"), Planes[2].Offset, (int64)15 + 6);
+	}
+	TestEqual(TEXT("I420 奇数尺寸字节数"), InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::I420, 5, 3), (int64)15 + 6 + 6);
+
+	// NV12：UV 交错在一个双通道平面
+	InVideoPlanes::GetPlaneLayout(EInVideoPlaneLayout::NV12, 5, 3, Planes);
+	if (TestEqual(TEXT("NV12 平面数"), Planes.Num(), 2))
+	{
+		TestTrue(TEXT("NV12 UV 格式"), Planes[1].Format == PF_R8G8);
+		TestEqual(TEXT("NV12 UV 宽"), Planes[1].Width, 3);
+		TestEqual(TEXT("NV12 UV 行距"), Planes[1].Pitch, 6);
+	}
+	TestEqual(TEXT("NV12 奇数尺寸字节数"), InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::NV12, 5, 3), (int64)15 + 12);
+
+	// 紧凑 BGR 作为 3 倍宽的单通道纹理
+	InVideoPlanes::GetPlaneLayout(EInVideoPlaneLayout::PackedBGR, 5, 3, Planes);
+	if (TestEqual(TEXT("BGR 平面数"), Planes.Num(), 1))
+	{
+		TestEqual(TEXT("BGR 纹理宽"), Planes[0].Width, 15);
+	}
+	TestEqual(TEXT("BGR 字节数"), InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::PackedBGR, 5, 3), (int64)45);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInVideoOddFrameBytesTest, "InVideo.PlaneUpload.OddFrameBytes",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FInVideoOddFrameBytesTest::RunTest(const FString& Parameters)
+{
+	// 解码器接收原始 YUV 帧和上传前都用 IsFrameComplete 检查，两边按同一布局计算
+	// 按 Height * 3 / 2 行分配的奇数高度帧少了一行色度，必须拒绝，否则上传会越界读取
+	const int32 Width = 6;
+	const int32 Height = 5;
+	const cv::Mat RoundedDown(Height * 3 / 2, Width, CV_8UC1);
+	TestFalse(TEXT("奇数高度 I420 向下取整的帧"),
+		InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::I420, Width, Height, (int64)RoundedDown.total() * RoundedDown.elemSize()));
+	TestFalse(TEXT("奇数高度 NV12 向下取整的帧"),
+		InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::NV12, Width, Height, (int64)RoundedDown.total() * RoundedDown.elemSize()));
+
+	// 按向上取整的色度分配的帧可以上传
+	const int64 FrameBytes = InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::I420, Width, Height);
+	TestEqual(TEXT("奇数高度 I420 字节数"), FrameBytes, (int64)Width * Height + 2 * 3 * 3);
+	const cv::Mat RoundedUp(1, (int32)FrameBytes, CV_8UC1);
+	TestTrue(TEXT("奇数高度 I420 完整的帧"),
+		InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::I420, Width, Height, (int64)RoundedUp.total() * RoundedUp.elemSize()));
+
+	// 奇数宽度同样需要向上取整
+	TestFalse(TEXT("奇数宽度 I420 向下取整的帧"),
+		InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::I420, 5, 4, (int64)5 * (4 * 3 / 2)));
+
+	// 解码时缩放输出偶数尺寸，按 Height * 3 / 2 行分配正好是一整帧
+	const cv::Mat Scaled(4 * 3 / 2, 6, CV_8UC1);
+	TestEqual(TEXT("缩放输出的字节数"), (int64)Scaled.total(), InVideoPlanes::GetFrameBytes(EInVideoPlaneLayout::I420, 6, 4));
+	TestTrue(TEXT("缩放输出完整"), InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::NV12, 6, 4, (int64)Scaled.total()));
+
+	TestFalse(TEXT("空帧"), InVideoPlanes::IsFrameComplete(EInVideoPlaneLayout::PackedBGR, 0, 0, 0));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -4,25 +4,61 @@
 
 #include "CoreMinimal.h"
 #include "Engine/GameViewportClient.h"
+#include "InVideoBufferPool.h"
 #include "InRecordGameViewportClient.generated.h"
 
+// 一帧采集结果，BGRA 紧密排列。来自帧池，Pixels 的容量跨帧保留
+struct FInRecordFrame
+{
+	TArray<FColor> Pixels;
+	int32 Width = 0;
+	int32 Height = 0;
+	// 缩小采集前的视口尺寸，未缩小时与 Width/Height 相同
+	int32 SourceWidth = 0;
+	int32 SourceHeight = 0;
+	// 游戏线程发起采集的时刻 (FPlatformTime::Seconds)
+	double CaptureSeconds = 0.0;
+};
+// 最后一个持有者（通常是编码线程）释放后帧回到池中
+using FInRecordFrameRef = TInVideoBufferPool<FInRecordFrame>::FBufferRef;
+
 /**
- * 
+ * 录制用的视口客户端：按帧率把视口画面异步回读到 CPU。
+ * 每次采集在渲染线程把视口纹理拷贝到 FRHIGPUTextureReadback 暂存区，最多 MaxFramesInFlight 帧同时在途，
+ * GPU 拷贝完成后在渲染线程取出像素，再在游戏线程交给 OnFrameData。游戏线程不等待 GPU。
+ * 像素从暂存区直接写入帧池中的帧，之后只移动引用，采集到编码之间不再拷贝。
  */
 UCLASS()
 class INVIDEO_API UInRecordGameViewportClient : public UGameViewportClient
 {
 	GENERATED_BODY()
-	
+
 public:
-	void StartRecord(const int Fps);
+	// FramePoolSize 限制采集帧的总内存：在途回读之后的帧都在等待编码，池耗尽时丢弃新采集的帧
+	void StartRecord(const int Fps, int32 FramePoolSize = DefaultFramePoolSize);
 	void StopRecord();
-	DECLARE_DELEGATE_ThreeParams(FFrameDelegate, TArray<FColor>, int32, int32);
+	// 每级把采集的边长减半（回读时隔行隔列取样），减少拷贝、转换和排队的内存
+	void SetCaptureDownscale(int32 Level);
+	// 本次录制在采集端丢弃的帧数
+	int32 GetCaptureDroppedFrames() const;
+	DECLARE_DELEGATE_OneParam(FFrameDelegate, FInRecordFrameRef&&);
 	FFrameDelegate OnFrameData;
 
 	virtual void Draw(FViewport* InViewport, FCanvas* SceneCanvas) override;
+
+	// 同时在途的回读帧数，全部未完成时跳过本次采集
+	static constexpr int32 MaxFramesInFlight = 3;
+	static constexpr int32 DefaultFramePoolSize = 8;
+	static constexpr int32 MaxCaptureDownscale = 2;
 private:
 	bool m_CanRecord = false;
 	double  m_FpsInterval = 10.0;
 	double m_LastTime;
+	// 每次 StartRecord/StopRecord 加一，旧录制的回读结果到达时丢弃
+	uint32 m_RecordGeneration = 0;
+	int32 m_CaptureDownscale = 0;
+	int32 m_FramePoolSize = 0;
+	// 回读槽位由渲染线程使用，渲染命令持有引用
+	TSharedPtr<struct FInRecordReadbackRing, ESPMode::ThreadSafe> m_ReadbackRing;
+	TSharedPtr<TInVideoBufferPool<FInRecordFrame>, ESPMode::ThreadSafe> m_FramePool;
 };
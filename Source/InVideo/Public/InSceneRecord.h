@@ -5,7 +5,9 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "HAL/Runnable.h"
-#include "Containers/Queue.h"
+#include "InRecordGameViewportClient.h"
+#include "InVideoRing.h"
+#include "InVideoStats.h"
 
 #include "PreOpenCVHeaders.h"
 #include <opencv2/core.hpp>
@@ -15,6 +17,20 @@
 
 #include "InSceneRecord.generated.h"
 
+// 录制队列满（编码跟不上）时的处理方式
+UENUM(BlueprintType)
+enum class EInRecordQueuePolicy : uint8
+{
+	// 游戏线程等待编码线程腾出空位，不丢帧但会拖慢帧率
+	BlockCapture,
+	// 丢弃新采集的帧
+	DropNewest,
+	// 丢弃队列中最旧的帧，保留最新画面
+	DropOldest,
+	// 丢弃新帧并降低采集分辨率，队列持续空闲后逐级恢复；编码时放大回原始尺寸
+	DegradeResolution
+};
+
 UCLASS()
 class INVIDEO_API AInSceneRecord : public AActor, public FRunnable
 {
@@ -32,8 +48,28 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "InVideo")
 	void StoptRecord();
 
+	UFUNCTION(BlueprintPure, Category = "InVideo|Record")
+	FInRecordStats GetRecordStats() const;
+
+	// 录制队列深度，队列和在途回读一起决定采集帧占用的内存上限
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Record", meta = (ClampMin = "1", ClampMax = "64"))
+	int32 QueueDepth = 8;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Record")
+	EInRecordQueuePolicy QueuePolicy = EInRecordQueuePolicy::DropOldest;
+
 	void OnRequestFrame();
-	void HandleFrameData(TArray<FColor> Bitmap, int32 x, int32 y);
+	void HandleFrameData(FInRecordFrameRef&& Frame);
+private:
+	// 按 QueuePolicy 放入录制队列，返回是否入队
+	bool EnqueueFrame(FInRecordFrameRef& Frame);
+	void UpdateDownscale(bool bQueueFull);
+	// 编码线程：取出当前队列中的所有帧依次写入，返回写入的帧数
+	int32 DrainQueue();
+	void EncodeFrame(FInRecordFrameRef& Frame);
+	void RecordEncoded(double CaptureSeconds);
+	// 编码线程等待新帧的超时，只用于兜底检查停止标志
+	static constexpr uint32 RecordWaitMs = 500;
 public:
 	bool Init() override;
 	uint32 Run() override;
@@ -44,7 +80,6 @@ private:
 	bool m_IsRecording = false;
 	FString m_FilePath;
 	int m_Fps = 0;
-	char* m_ImageBuf = nullptr;
 	int32 m_ImageX = 0;
 	int32 m_ImageY = 0;
 	
@@ -52,12 +87,28 @@ private:
 	{
 	public:
 		cv::VideoWriter m_VideoWriter;
-		TQueue<TArray<FColor>> m_ImageQueue;
+		// 只传递帧引用，编码后帧回到视口客户端的帧池
+		TInVideoRing<FInRecordFrameRef> m_ImageQueue;
+		// 编码用的 BGR 缓冲，只在录制线程使用，跨帧复用
+		cv::Mat m_BgrFrame;
+		// 缩小采集的帧放大回输出尺寸
+		cv::Mat m_ScaledFrame;
+		cv::Size m_OutputSize;
 	};
 	WrapOpenCv* m_WrapOpenCv = nullptr;
 
 	FRunnableThread* m_Thread = nullptr;
 	TAtomic<bool> m_Stopping = false;
 
+	TWeakObjectPtr<UInRecordGameViewportClient> m_ViewportClient;
+	// DegradeResolution 的当前级数和队列连续为空的入队次数，只在游戏线程使用
+	int32 m_DownscaleLevel = 0;
+	int32 m_EmptyStreak = 0;
+	TAtomic<int32> m_DroppedFrames{ 0 };
+	TAtomic<int32> m_EncodedFrames{ 0 };
+	mutable FCriticalSection m_StatsMutex;
+	float m_LastEncodeLagMs = 0.0f;
+	float m_MaxEncodeLagMs = 0.0f;
+
 	
 };
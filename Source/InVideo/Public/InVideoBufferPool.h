@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/SharedPointer.h"
+
+/**
+ * 固定数量的缓冲区池。Acquire 返回线程安全的引用计数指针，
+ * 最后一个持有者（通常是渲染命令）释放时缓冲区自动回到池中，因此缓冲区在被消费完之前不会被复用。
+ * 池本身先于缓冲区销毁时，缓冲区在最后一次释放时直接删除。
+ */
+template <typename BufferType>
+class TInVideoBufferPool : public TSharedFromThis<TInVideoBufferPool<BufferType>, ESPMode::ThreadSafe>
+{
+public:
+	using FBufferRef = TSharedPtr<BufferType, ESPMode::ThreadSafe>;
+
+	static TSharedRef<TInVideoBufferPool, ESPMode::ThreadSafe> Create(int32 MaxBuffers)
+	{
+		return MakeShared<TInVideoBufferPool, ESPMode::ThreadSafe>(MaxBuffers);
+	}
+
+	explicit TInVideoBufferPool(int32 MaxBuffers)
+		: m_MaxBuffers(FMath::Max(1, MaxBuffers))
+	{
+	}
+	~TInVideoBufferPool()
+	{
+		for (BufferType* Buffer : m_Free)
+		{
+			delete Buffer;
+		}
+	}
+	TInVideoBufferPool(const TInVideoBufferPool&) = delete;
+	TInVideoBufferPool& operator=(const TInVideoBufferPool&) = delete;
+
+	// 取一个空闲缓冲区，全部在使用中时返回空指针，由调用者决定丢弃还是重试
+	FBufferRef Acquire()
+	{
+		BufferType* Buffer = nullptr;
+		{
+			FScopeLock Lock(&m_Mutex);
+			if (m_Free.Num() > 0)
+			{
+				Buffer = m_Free.Pop(false);
+			}
+			else if (m_NumCreated < m_MaxBuffers)
+			{
+				Buffer = new BufferType();
+				++m_NumCreated;
+			}
+			else
+			{
+				return FBufferRef();
+			}
+		}
+
+		TWeakPtr<TInVideoBufferPool, ESPMode::ThreadSafe> WeakPool = this->AsShared();
+		return FBufferRef(Buffer, [WeakPool](BufferType* Released)
+			{
+				TSharedPtr<TInVideoBufferPool, ESPMode::ThreadSafe> Pool = WeakPool.Pin();
+				if (Pool.IsValid())
+				{
+					Pool->Recycle(Released);
+				}
+				else
+				{
+					delete Released;
+				}
+			});
+	}
+
+	// 当前被持有（尚未回收）的缓冲区数量
+	int32 NumInFlight() const
+	{
+		FScopeLock Lock(&m_Mutex);
+		return m_NumCreated - m_Free.Num();
+	}
+
+private:
+	void Recycle(BufferType* Buffer)
+	{
+		FScopeLock Lock(&m_Mutex);
+		m_Free.Push(Buffer);
+	}
+
+private:
+	mutable FCriticalSection m_Mutex;
+	TArray<BufferType*> m_Free;
+	int32 m_MaxBuffers = 1;
+	int32 m_NumCreated = 0;
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "InVideoStats.h"
+
+/**
+ * 显示时钟：以 FPlatformTime::Seconds 为单调时基，按帧的 PTS 计算绝对显示时刻。
+ * 每帧的显示时刻都从同一基准推算，不会因逐帧累加而漂移；帧号逆着播放方向变化（回绕、方向切换）、
+ * Seek、速率变化或暂停恢复时重新建立基准。
+ * Schedule/OnPresented 等只在显示线程调用，FillStats 可在任意线程调用。
+ */
+class FInVideoClock
+{
+public:
+	// 抖动直方图的分桶上界 (ms)，最后一桶为超过最大上界的部分
+	static constexpr int32 NumJitterBuckets = 7;
+	static const float JitterBucketBoundsMs[NumJitterBuckets - 1];
+
+	void Reset();
+
+	// 每次显示前调用，速率或方向变化时以上一帧为基准继续推算
+	void SetRate(double Rate, bool bReverse);
+	void Pause(double NowSeconds);
+	void Resume();
+
+	// 返回该帧应显示的单调时刻（秒）
+	double Schedule(int32 FrameIndex, double PtsMs, double FrameDurationMs, double NowSeconds);
+	// 一帧的显示时长（秒），已计入播放速率
+	double GetFrameSeconds(double FrameDurationMs) const;
+
+	// 记录实际显示时刻，晚于一个帧间隔的部分按重复帧统计
+	void OnPresented(double DueSeconds, double NowSeconds, double FrameSeconds);
+	// 下一帧也已到期，本帧被跳过
+	void OnDropped();
+
+	void FillStats(FInVideoPlayerStats& OutStats) const;
+	void LogSummary(const FString& VideoURL) const;
+
+private:
+	// 仅显示线程访问
+	bool m_bHasBase = false;
+	double m_BaseSeconds = 0.0;
+	double m_BasePtsMs = 0.0;
+	double m_Rate = 1.0;
+	int32 m_Direction = 1;
+	int32 m_LastIndex = INDEX_NONE;
+	double m_LastPtsMs = 0.0;
+	double m_LastDueSeconds = 0.0;
+
+	// 统计，受 m_Mutex 保护
+	mutable FCriticalSection m_Mutex;
+	int32 m_JitterHistogram[NumJitterBuckets] = {};
+	int32 m_PresentedFrames = 0;
+	int32 m_DroppedFrames = 0;
+	int32 m_RepeatedFrames = 0;
+	double m_TotalAbsJitterMs = 0.0;
+	double m_MaxJitterMs = 0.0;
+	// 有符号误差的指数滑动平均，持续为正说明显示跟不上时钟
+	double m_DriftMs = 0.0;
+	// 累计运行时长，不含暂停；从第一帧显示开始计时
+	double m_RunSeconds = 0.0;
+	double m_RunStartSeconds = -1.0;
+};
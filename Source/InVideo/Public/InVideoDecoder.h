@@ -0,0 +1,279 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "InVideoRing.h"
+#include "InVideoPlaneUpload.h"
+#include "InVideoKeyframeIndex.h"
+#include "InVideoStats.h"
+#include "InVideoWorkerPool.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include "PostOpenCVHeaders.h"
+
+// 解码线程输出的一帧
+struct FInVideoFrame
+{
+	cv::Mat Image;
+	int32 FrameIndex = 0;
+	// 显示时间戳 (ms)，后端不提供时按帧号和帧率推算
+	double PtsMs = 0.0;
+	// 直播流：采集时刻的 Unix 时间 (ms)，来自 CAP_PROP_STREAM_OPEN_TIME_USEC + PTS，源不提供时为负数
+	double CaptureEpochMs = -1.0;
+	// 解码完成时的 FPlatformTime::Seconds
+	double DecodedSeconds = 0.0;
+	// Image 的内存布局，YUV 布局时 Image 为 Height*3/2 行的单通道 Mat
+	EInVideoPlaneLayout Layout = EInVideoPlaneLayout::PackedBGR;
+	// 亮度平面尺寸
+	int32 Width = 0;
+	int32 Height = 0;
+};
+
+// UE 的 Swap 按字节交换，而 cv::Mat 的 size.p/step.p 指向自身成员，按字节交换后会指向对方。
+// 队列和缓存交换帧时通过这里走 cv::Mat 的移动操作（环形队列模板内的 Swap 经 ADL 找到此重载）
+inline void Swap(FInVideoFrame& A, FInVideoFrame& B)
+{
+	FInVideoFrame Temp = MoveTemp(A);
+	A = MoveTemp(B);
+	B = MoveTemp(Temp);
+}
+
+// 控件不可见时解码器的节流等级，按从轻到重排列，共享源取所有订阅者中最轻的一级
+enum class EInVideoDecodeThrottle : uint8
+{
+	None,
+	// 限制输出帧率：文件源跳过的帧只 grab 不做颜色转换，直播源只在到期时 retrieve
+	ReduceRate,
+	// 文件源有关键帧索引时只解码关键帧，其余情况同 ReduceRate
+	KeyframesOnly,
+	// 文件源停止解码；直播源只 grab 保持网络会话
+	Suspend
+};
+
+/**
+ * 解码阶段：按 Tick 从 cv::VideoCapture 读取帧并写入有界环形队列，
+ * 不做任何显示节奏控制，显示节奏由消费者（VideoPlay）负责。
+ * 文件源在共享工作线程池上解码，打开、预取和备用流定位在后台进行，Tick 只轮询结果；
+ * 直播和网络流的 open/grab 会阻塞到超时，这类源在独占的 I/O 线程上调度。
+ */
+class FInVideoDecoder
+{
+public:
+	FInVideoDecoder(TInVideoRing<FInVideoFrame>& Ring);
+	virtual ~FInVideoDecoder();
+
+	void Start(const FString& VideoURL, const bool RealMode);
+	void StopDecode();
+
+	// 以下接口可在任意线程调用，实际操作在解码线程执行
+	void Seek(int32 FrameIndex);
+	void SetReverse(bool bReverse);
+	void SetPaused(bool bPaused);
+	// 请求解码器输出原生 YUV 平面（CAP_PROP_CONVERT_RGB = 0），不支持时自动退回 BGR
+	void SetNativeOutput(bool bNative);
+	// 反向播放缓存的内存上限（当前段 + 预取段）
+	void SetReverseCacheBudget(int64 Bytes);
+	// 无缝循环：缓存片头 HeadFrames 帧，回绕时直接从内存交出，同时由备用 VideoCapture 在后台定位到片头之后
+	void SetGaplessLoop(bool bEnable, int32 HeadFrames);
+	// 低延迟直播：读取时用 grab 丢弃积压帧，只解出最新一帧。超时参数对所有网络流生效
+	void SetLiveMode(bool bLive, int32 OpenTimeoutMs, int32 ReadTimeoutMs);
+	// 网络直播流断流（读取超时）后在解码线程按带抖动的指数退避重连，MaxAttempts 为 0 表示不限次数
+	void SetReconnect(bool bEnable, float InitialDelaySeconds, float MaxDelaySeconds, int32 MaxAttempts);
+	// 解码时缩放到该尺寸（只缩小），0 表示原始尺寸。BGR 输出时先缩放 YUV 平面再做颜色转换
+	void SetOutputSize(FIntPoint Size);
+	// 不可见时的节流，MaxFps 为 ReduceRate/KeyframesOnly 的输出帧率上限
+	void SetThrottle(EInVideoDecodeThrottle Throttle, float MaxFps);
+
+	// 流的帧间隔 (ms)，打开前返回 0
+	double GetFrameDurationMs() const;
+
+	// 填充 Seek 相关统计
+	void GetStats(FInVideoPlayerStats& OutStats) const;
+
+	// rtsp/http 等网络流，不建立关键帧索引
+	static bool IsNetworkURL(const FString& VideoURL);
+
+	TFunction<void()> OnFailed;
+	// 正向播放到达末尾时触发，每次回绕都会触发；首播完成由源按订阅者判断
+	TFunction<void()> OnReachedEnd;
+	// 重连回调在解码线程触发，参数为第几次尝试和本次等待的秒数
+	TFunction<void(int32, float)> OnReconnecting;
+	TFunction<void()> OnRecovered;
+	// 一帧放入队列后触发，用于唤醒显示任务
+	TFunction<void()> OnFramePushed;
+	// Seek 生效并清空队列后触发，在解码线程
+	TFunction<void()> OnSeekApplied;
+
+	// 队列腾出空位或状态变化时调用，让解码任务尽快执行
+	void Wake();
+private:
+	enum class EDecodeState : uint8
+	{
+		Opening,
+		Decoding,
+		Reconnecting,
+		Finished
+	};
+	// 工作线程池的调度入口，返回下一次执行的时刻
+	double Tick(double NowSeconds);
+	double TickOpen(double NowSeconds);
+	double TickReconnect(double NowSeconds);
+	bool InitStream();
+	bool PushPendingFrame();
+	bool OpenStream();
+	bool DecodeStep();
+	bool ReadLive();
+	bool ReadRealtime();
+	// 节流时直播源只 grab，返回下一次执行的时刻
+	double KeepLiveSessionAlive(double NowSeconds);
+	// 节流时文件源跳过本帧之后的若干帧
+	void SkipThrottledFrames(EInVideoDecodeThrottle Throttle);
+	// 直播或没有总帧数的网络流，读取失败视为断流而不是文件结束
+	bool IsLiveSource() const;
+	// 直播读取失败：开启重连时开始重连，否则连续失败 MaxLiveReadFailures 次后结束并通知失败
+	void HandleLiveReadFailure(double NowSeconds);
+	void BeginReconnect(double NowSeconds);
+	void ScheduleReconnect(double NowSeconds);
+	double GetReconnectDelay(int32 Attempt) const;
+	bool ConsumeSimulatedDrop();
+	bool ReadForward();
+	bool ReadReverse();
+	bool FillReverseChunk();
+	// 在后台打开预取流并解码 [Start, End) 到预取段，预取流不可用时返回 false
+	bool StartPrefetch(int32 Start, int32 End);
+	// 作废反向缓存；正在后台解码的段不等待，完成后丢弃
+	void ResetReverseCache();
+	int32 GetReverseChunkFrames() const;
+	void ApplyPendingSeek();
+	void UpdateKeyframeIndex();
+	// 跳到最近的前一个关键帧再顺序解码到目标帧，记录耗时
+	void SeekToFrame(cv::VideoCapture& Stream, int32 FrameIndex);
+	int32 GetReverseChunkStart(int32 End) const;
+	void CaptureLoopHead();
+	// 正在后台定位的备用流不等待，完成后由 PollLoopStream 释放
+	void ResetLoopHead();
+	void PollLoopStream();
+	bool TryGaplessWrap();
+	void PrepareLoopStream();
+	void ConfigureNativeOutput();
+	// 根据请求的输出尺寸决定本次 Tick 是否在解码时缩放，并切换 CONVERT_RGB
+	void UpdateOutputScale();
+	// 需要缩放或转换颜色时读取写入 m_DecodeImage，否则直接写入 m_Frame.Image
+	bool ReadsToDecodeImage() const;
+	cv::Mat& GetReadTarget();
+	// 把 m_DecodeImage 缩放/转换到 m_Frame，队列槽位保持输出尺寸，跨帧复用不重新分配
+	void ScaleToOutput();
+	bool ClassifyFrame();
+	double ReadPts(const cv::VideoCapture& Stream, int32 FrameIndex) const;
+	void Fail();
+private:
+	TInVideoRing<FInVideoFrame>& m_Ring;
+	FInVideoWorkerPool::FTaskHandle m_Task;
+	// 直播和网络流在工作线程池的 I/O 线程组上调度，open/grab 可以阻塞
+	bool m_bBlockingIO = false;
+	EDecodeState m_State = EDecodeState::Opening;
+	// 文件源在后台打开，TickOpen 轮询
+	TFuture<bool> m_OpenFuture;
+	// 本次读取在等待后台解码，Tick 稍后重试而不是按失败处理
+	bool m_bIoPending = false;
+	bool m_bStreamInitialized = false;
+	// m_Frame 已解码但队列满，尚未放入
+	bool m_bFramePending = false;
+	double m_NextReconnectSeconds = 0.0;
+	TAtomic<bool> m_Stopping = false;
+	TAtomic<bool> m_bReverse = false;
+	TAtomic<bool> m_bPaused = false;
+	TAtomic<int32> m_PendingSeek = INDEX_NONE;
+	TAtomic<uint8> m_Throttle = (uint8)EInVideoDecodeThrottle::None;
+	TAtomic<int32> m_ThrottleIntervalMs = 500;
+	// 节流时直播源下一次 retrieve 的时刻
+	double m_NextThrottledFrameSeconds = 0.0;
+	FString m_VideoURL;
+	bool m_RealMode = true;
+	int32 m_CurrentFrameIndex = 0;
+	int32 m_TotalFrames = 0;
+	double m_FrameDurationMs = 0.0;
+	bool m_bNativeOutput = false;
+	bool m_bRawYUV = false;
+	EInVideoPlaneLayout m_RawLayout = EInVideoPlaneLayout::I420;
+	int32 m_Width = 0;
+	int32 m_Height = 0;
+
+	cv::VideoCapture m_Stream;
+	// 正在写入的帧，Push 后会换回一个可复用的槽位
+	FInVideoFrame m_Frame;
+
+	// 解码时缩放：全尺寸解码缓冲和 YUV 缩放中间结果，跨帧复用
+	FIntPoint m_RequestedOutputSize = FIntPoint::ZeroValue;
+	FIntPoint m_OutputSize = FIntPoint::ZeroValue;
+	bool m_bScaleOutput = false;
+	cv::Mat m_DecodeImage;
+	cv::Mat m_ScaledYUV;
+
+	// 反向播放：按段正向解码一次并缓存，再倒序交出；同时在后台用另一个 VideoCapture 预取前一段
+	struct FReverseChunk
+	{
+		TArray<FInVideoFrame> Frames;
+		int32 Start = 0;
+		int32 End = 0;
+		// 尚未交出的帧数，从后往前交出
+		int32 Remaining = 0;
+	};
+	bool DecodeChunk(cv::VideoCapture& Stream, int32 Start, int32 End, FReverseChunk& Chunk);
+
+	bool m_bDecodingReverse = false;
+	int64 m_ReverseCacheBytes = 256ll * 1024 * 1024;
+	int32 m_ReverseGopFrames = 50;
+	FReverseChunk m_ReverseChunk;
+	FReverseChunk m_PrefetchChunk;
+	// 结果为预取流是否可用
+	TFuture<bool> m_PrefetchFuture;
+	// 正在后台解码的段已被 Seek/方向切换作废
+	bool m_bDiscardPrefetch = false;
+	// 预取流打不开，之后反向播放同步解码
+	bool m_bPrefetchUnavailable = false;
+	cv::VideoCapture m_PrefetchStream;
+
+	// 后台建立的关键帧索引，建立完成前 Seek 直接交给后端
+	TFuture<TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe>> m_IndexFuture;
+	TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> m_KeyframeIndex;
+
+	// 无缝循环
+	bool m_bGaplessLoop = false;
+	int32 m_LoopHeadFrames = 10;
+	TArray<FInVideoFrame> m_LoopHead;
+	// 正在从片头缓存交出的位置，INDEX_NONE 表示未在交出
+	int32 m_LoopHeadCursor = INDEX_NONE;
+	cv::VideoCapture m_LoopStream;
+	TFuture<bool> m_LoopStreamFuture;
+	bool m_bDiscardLoopStream = false;
+
+	// 低延迟直播
+	bool m_bLive = false;
+	int32 m_OpenTimeoutMs = 5000;
+	int32 m_ReadTimeoutMs = 3000;
+	double m_StreamOpenTimeUs = 0.0;
+
+	// 断流重连
+	bool m_bAutoReconnect = true;
+	float m_ReconnectInitialDelay = 0.5f;
+	float m_ReconnectMaxDelay = 30.0f;
+	int32 m_ReconnectMaxAttempts = 0;
+	int32 m_SimulatedDropGeneration = 0;
+	// 未开启重连时连续读取失败的次数
+	int32 m_LiveReadFailures = 0;
+
+	mutable FCriticalSection m_StatsMutex;
+	int32 m_SeekCount = 0;
+	double m_LastSeekMs = 0.0;
+	double m_TotalSeekMs = 0.0;
+	double m_MaxSeekMs = 0.0;
+	int32 m_LiveDrainedFrames = 0;
+	bool m_bReconnecting = false;
+	int32 m_ReconnectAttempt = 0;
+	int32 m_ReconnectCount = 0;
+	int32 m_ThrottledFrames = 0;
+};
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 文件源的关键帧索引。
+ * 打开时用原始包模式 (CAP_PROP_FORMAT = -1) 扫描一遍，不解码，只记录关键帧位置和时间戳；
+ * 结果缓存在 Saved/InVideo/KeyframeIndex 下，文件大小或修改时间变化时重建。
+ */
+class FInVideoKeyframeIndex
+{
+public:
+	// 加载缓存或扫描生成索引，失败返回空指针。耗时操作，应在后台线程调用
+	static TSharedPtr<const FInVideoKeyframeIndex, ESPMode::ThreadSafe> LoadOrBuild(const FString& VideoURL);
+
+	// 不晚于 FrameIndex 的最近关键帧，O(1) 查表
+	int32 GetKeyframeAtOrBefore(int32 FrameIndex) const;
+	// FrameIndex 所在 GOP 的下一个关键帧，没有则返回总帧数
+	int32 GetNextKeyframe(int32 FrameIndex) const;
+
+	int32 GetTotalFrames() const { return m_TotalFrames; }
+	int32 GetNumKeyframes() const { return m_KeyframeFrames.Num(); }
+	const TArray<int32>& GetKeyframeFrames() const { return m_KeyframeFrames; }
+	const TArray<double>& GetKeyframeTimesMs() const { return m_KeyframeTimesMs; }
+
+private:
+	bool Build(const FString& VideoURL);
+	bool Load(const FString& CachePath, int64 FileSize, int64 FileTimestamp);
+	void Save(const FString& CachePath, int64 FileSize, int64 FileTimestamp) const;
+	void BuildLookup();
+	static FString GetCachePath(const FString& VideoURL);
+
+private:
+	int32 m_TotalFrames = 0;
+	TArray<int32> m_KeyframeFrames;
+	TArray<double> m_KeyframeTimesMs;
+	// 每帧对应的关键帧在 m_KeyframeFrames 中的下标
+	TArray<int32> m_FrameToKeyframe;
+};
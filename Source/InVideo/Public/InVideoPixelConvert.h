@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 像素格式转换内核。
+ * 每个转换都有一个标量参考实现和一个按 CPU 能力分发的向量化实现（x86 上 AVX2/SSSE3，ARM 上 NEON），
+ * 图像级接口按行分块并行，每块行数保证工作集能留在缓存中。
+ * 控制台命令 InVideo.BenchPixelConvert 和 InVideo.BenchRecordConvert 输出各实现的吞吐量 (GB/s)。
+ */
+namespace InVideoPixelConvert
+{
+	// BGR24 => BGRA32 (即 FColor)，Alpha 填 255
+	void BGRToBGRA_Scalar(const uint8* Src, uint8* Dst, int32 NumPixels);
+	void BGRToBGRA(const uint8* Src, uint8* Dst, int32 NumPixels);
+
+	// 整幅图像转换，Stride 以字节为单位，支持非连续行
+	void BGRToBGRAImage(const uint8* Src, int32 SrcStride, uint8* Dst, int32 DstStride, int32 Width, int32 Height);
+
+	// BGRA32 (即 FColor) => BGR24，丢弃 Alpha，用于录制编码
+	void BGRAToBGR_Scalar(const uint8* Src, uint8* Dst, int32 NumPixels);
+	void BGRAToBGR(const uint8* Src, uint8* Dst, int32 NumPixels);
+	void BGRAToBGRImage(const uint8* Src, int32 SrcStride, uint8* Dst, int32 DstStride, int32 Width, int32 Height);
+
+	// BGRA32 2x2 盒式下采样，输出下一级 mip（尺寸为源的一半，最小 1），源尺寸为奇数时边缘像素重复取样
+	void DownsampleBGRA2x2(const uint8* Src, int32 SrcStride, int32 SrcWidth, int32 SrcHeight, uint8* Dst, int32 DstStride);
+
+	// 当前分发到的实现名称，用于日志
+	const TCHAR* GetKernelName();
+}
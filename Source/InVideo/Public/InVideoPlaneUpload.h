@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "RHI.h"
+
+#include "InVideoPlaneUpload.generated.h"
+
+class FTextureRenderTargetResource;
+
+// 纹理上传方式
+UENUM(BlueprintType)
+enum class EInVideoUploadMode : uint8
+{
+	// CPU 把 BGR 展开成 BGRA 后上传（兼容路径）
+	RGBA,
+	// 直接上传解码器原生输出（NV12/I420 平面或紧凑 BGR），在像素着色器中转换颜色
+	Native
+};
+
+// 解码帧在内存中的平面布局
+enum class EInVideoPlaneLayout : uint8
+{
+	PackedBGR,
+	I420,
+	NV12
+};
+
+// 单个平面在上传缓冲区中的位置和对应的纹理格式
+struct FInVideoPlaneDesc
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	EPixelFormat Format = PF_G8;
+	int32 BytesPerPixel = 1;
+	int64 Offset = 0;
+	int32 Pitch = 0;
+};
+
+using FInVideoPlaneDescArray = TArray<FInVideoPlaneDesc, TFixedAllocator<3>>;
+
+namespace InVideoPlanes
+{
+	// 计算紧凑排列的帧（无行填充）中各平面的布局，Width/Height 为亮度尺寸
+	void GetPlaneLayout(EInVideoPlaneLayout Layout, int32 Width, int32 Height, FInVideoPlaneDescArray& OutPlanes);
+
+	// 紧凑排列的帧总字节数
+	int64 GetFrameBytes(EInVideoPlaneLayout Layout, int32 Width, int32 Height);
+
+	// Bytes 字节的数据是否装得下整帧；解码器接收帧和上传前都用它检查，奇数尺寸按向上取整的色度计算
+	bool IsFrameComplete(EInVideoPlaneLayout Layout, int32 Width, int32 Height, int64 Bytes);
+}
+
+/**
+ * 渲染线程持有的平面纹理，负责上传各平面并用像素着色器转换到输出渲染目标。
+ * 只能在渲染线程访问。
+ */
+class FInVideoPlaneTextures
+{
+public:
+	void UploadAndConvert(FRHICommandListImmediate& RHICmdList, EInVideoPlaneLayout Layout,
+		int32 Width, int32 Height, const uint8* Data, FTextureRenderTargetResource* Target);
+
+private:
+	void EnsurePlanes(const FInVideoPlaneDescArray& Planes);
+
+	FTextureRHIRef m_Planes[3];
+	FInVideoPlaneDesc m_PlaneDescs[3];
+};
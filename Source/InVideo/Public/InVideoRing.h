@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+#include "InVideoRing.generated.h"
+
+// 队列满时的处理策略
+UENUM(BlueprintType)
+enum class EInVideoQueueFullPolicy : uint8
+{
+	// 覆盖最旧的元素，生产者永不阻塞
+	DropOldest,
+	// 生产者等待消费者腾出空位
+	Block
+};
+
+/**
+ * 预分配的有界环形队列，用于解码线程与显示线程之间传递帧。
+ * Push/Pop 通过 Swap 交换元素，槽位里的内存（如 cv::Mat 的像素缓冲）会被循环复用，稳定运行后不再分配。
+ */
+template <typename ElementType>
+class TInVideoRing
+{
+public:
+	TInVideoRing()
+	{
+		m_NotFullEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		m_NotEmptyEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	}
+	~TInVideoRing()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(m_NotFullEvent);
+		FPlatformProcess::ReturnSynchEventToPool(m_NotEmptyEvent);
+	}
+	TInVideoRing(const TInVideoRing&) = delete;
+	TInVideoRing& operator=(const TInVideoRing&) = delete;
+
+	// 重新设置深度和策略，会清空队列并预分配槽位
+	void Reset(int32 Depth, EInVideoQueueFullPolicy Policy)
+	{
+		FScopeLock Lock(&m_Mutex);
+		m_Slots.Reset();
+		m_Slots.SetNum(FMath::Max(1, Depth));
+		m_Policy = Policy;
+		m_Head = 0;
+		m_Count = 0;
+		m_DroppedCount = 0;
+	}
+
+	// 放入一个元素，InOutItem 换回一个可复用的旧槽位内容。
+	// Block 策略下队列满时等待，bAbort 变为 true 时放弃并返回 false。
+	bool Push(ElementType& InOutItem, const TAtomic<bool>& bAbort)
+	{
+		while (false == bAbort)
+		{
+			if (TryPush(InOutItem))
+			{
+				return true;
+			}
+			m_NotFullEvent->Wait(10);
+		}
+		return false;
+	}
+
+	// 不等待的 Push：Block 策略下队列满时直接返回 false，InOutItem 保持不变
+	bool TryPush(ElementType& InOutItem)
+	{
+		FScopeLock Lock(&m_Mutex);
+		const int32 Depth = m_Slots.Num();
+		if (m_Count < Depth)
+		{
+			Swap(m_Slots[(m_Head + m_Count) % Depth], InOutItem);
+			++m_Count;
+			m_NotEmptyEvent->Trigger();
+			return true;
+		}
+		if (m_Policy == EInVideoQueueFullPolicy::DropOldest)
+		{
+			// 最旧的槽位被新元素覆盖，队头后移
+			Swap(m_Slots[m_Head], InOutItem);
+			m_Head = (m_Head + 1) % Depth;
+			++m_DroppedCount;
+			m_NotEmptyEvent->Trigger();
+			return true;
+		}
+		return false;
+	}
+
+	// TryPush 是否会成功：有空位或策略为 DropOldest
+	bool CanPush() const
+	{
+		FScopeLock Lock(&m_Mutex);
+		return m_Count < m_Slots.Num() || m_Policy == EInVideoQueueFullPolicy::DropOldest;
+	}
+
+	// 取出最旧的元素，InOutItem 原有内容换回队列以便复用
+	bool Pop(ElementType& InOutItem)
+	{
+		FScopeLock Lock(&m_Mutex);
+		if (m_Count == 0)
+		{
+			return false;
+		}
+		Swap(m_Slots[m_Head], InOutItem);
+		m_Head = (m_Head + 1) % m_Slots.Num();
+		--m_Count;
+		m_NotFullEvent->Trigger();
+		return true;
+	}
+
+	// 等待队列非空，超时返回 false
+	bool WaitNotEmpty(uint32 WaitMs)
+	{
+		if (Num() > 0)
+		{
+			return true;
+		}
+		m_NotEmptyEvent->Wait(WaitMs);
+		return Num() > 0;
+	}
+
+	// 丢弃所有待处理元素（槽位内存保留）
+	void Clear()
+	{
+		FScopeLock Lock(&m_Mutex);
+		m_Head = 0;
+		m_Count = 0;
+		m_NotFullEvent->Trigger();
+	}
+
+	// 唤醒所有等待中的生产者和消费者，用于停止线程
+	void Wake()
+	{
+		m_NotFullEvent->Trigger();
+		m_NotEmptyEvent->Trigger();
+	}
+
+	int32 Num() const
+	{
+		FScopeLock Lock(&m_Mutex);
+		return m_Count;
+	}
+	int32 Capacity() const
+	{
+		FScopeLock Lock(&m_Mutex);
+		return m_Slots.Num();
+	}
+	uint32 GetDroppedCount() const
+	{
+		FScopeLock Lock(&m_Mutex);
+		return m_DroppedCount;
+	}
+
+private:
+	mutable FCriticalSection m_Mutex;
+	TArray<ElementType> m_Slots;
+	EInVideoQueueFullPolicy m_Policy = EInVideoQueueFullPolicy::Block;
+	int32 m_Head = 0;
+	int32 m_Count = 0;
+	uint32 m_DroppedCount = 0;
+	FEvent* m_NotFullEvent = nullptr;
+	FEvent* m_NotEmptyEvent = nullptr;
+};
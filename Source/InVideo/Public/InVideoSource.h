@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/SharedPointer.h"
+#include "InVideoRing.h"
+#include "InVideoDecoder.h"
+#include "InVideoStats.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include "PostOpenCVHeaders.h"
+
+// 打开视频源的参数，影响解码输出的部分参与共享源的键
+struct FInVideoSourceOptions
+{
+	bool bRealMode = true;
+	bool bNativeOutput = false;
+	bool bLive = false;
+	int32 OpenTimeoutMs = 5000;
+	int32 ReadTimeoutMs = 3000;
+	bool bGaplessLoop = false;
+	int32 LoopHeadFrames = 10;
+	int64 ReverseCacheBytes = 256ll * 1024 * 1024;
+	bool bReverse = false;
+	bool bAutoReconnect = true;
+	float ReconnectInitialDelay = 0.5f;
+	float ReconnectMaxDelay = 30.0f;
+	int32 ReconnectMaxAttempts = 0;
+
+	// 规范化的 URL + 解码选项 + 初始播放方向，超时、重连和缓存预算沿用第一个订阅者的设置
+	FString MakeKey(const FString& VideoURL) const;
+};
+
+// 订阅者：接收帧的队列和解码事件回调，回调在解码线程或其他订阅者的显示线程触发
+struct FInVideoSourceSubscriber
+{
+	TInVideoRing<FInVideoFrame>* Ring = nullptr;
+	// 期望的输出尺寸，0 表示原始尺寸；只对 BGR 帧生效，YUV 平面由着色器缩放
+	FIntPoint OutputSize = FIntPoint::ZeroValue;
+	// 输出尺寸只用于缩小（跟随控件尺寸时），不把视频放大到比原始尺寸更大
+	bool bShrinkOnly = false;
+	bool bPaused = false;
+	// 控件不可见时的节流，Suspend 的订阅者不接收帧
+	EInVideoDecodeThrottle Throttle = EInVideoDecodeThrottle::None;
+	float ThrottleFps = 2.0f;
+
+	TFunction<void()> OnFramePushed;
+	TFunction<void()> OnFailed;
+	// 从该订阅者收到的第一帧起完整播放一遍后触发一次，中途加入共享源的订阅者播放到加入点之前才算完成
+	TFunction<void()> OnFirstPlayCompleted;
+	TFunction<void(int32, float)> OnReconnecting;
+	TFunction<void()> OnRecovered;
+	// Seek 生效，订阅者队列已清空，已取出未显示的帧应作废
+	TFunction<void()> OnSeekApplied;
+	// 其他订阅者切换了共享源的播放方向
+	TFunction<void(bool)> OnReverseChanged;
+};
+
+/**
+ * 视频源：一个 FInVideoDecoder 解码，结果分发给所有订阅的 VideoPlay。
+ * 相同 URL 和解码选项的控件通过 Acquire 共享同一个源（按引用计数，最后一个订阅者释放时停止解码），
+ * 同一路摄像头只打开一个网络会话。每种输出尺寸每帧只缩放一次，全部订阅者都缩小显示时在解码阶段缩放。
+ * Seek 和播放方向作用于共享源的所有订阅者；暂停按订阅者独立，全部暂停时才暂停解码。
+ * Block 策略的订阅者队列满时整体等待，每个订阅者收到完整的帧序列；已暂停的订阅者不接收帧。
+ * 解码器的节流取所有订阅者中最轻的一级，任何一个控件可见时全速解码。
+ * 首播完成按订阅者计算，从各自加入时的帧起算，不因为共享源先到达末尾而提前通知后加入的订阅者。
+ */
+class FInVideoSource : public TSharedFromThis<FInVideoSource, ESPMode::ThreadSafe>
+{
+public:
+	using FSourceRef = TSharedPtr<FInVideoSource, ESPMode::ThreadSafe>;
+
+	// bShared 为 false 时创建独占的源，不进入注册表
+	static FSourceRef Acquire(const FString& VideoURL, const FInVideoSourceOptions& Options, bool bShared);
+	// 注册表的键使用的 URL 形式：本地文件转为绝对路径
+	static FString NormalizeURL(const FString& VideoURL);
+
+	~FInVideoSource();
+
+	// 返回订阅者编号，第一个订阅者负责启动解码
+	int32 Subscribe(FInVideoSourceSubscriber Subscriber);
+	// 返回后不会再向订阅者的队列写入或触发回调
+	void Unsubscribe(int32 SubscriberId);
+	void SetOutputSize(int32 SubscriberId, FIntPoint OutputSize, bool bShrinkOnly = false);
+	void SetSubscriberPaused(int32 SubscriberId, bool bPaused);
+	void SetSubscriberThrottle(int32 SubscriberId, EInVideoDecodeThrottle Throttle, float MaxFps);
+
+	void Seek(int32 FrameIndex);
+	void SetReverse(bool bReverse);
+	// 订阅者取走一帧后调用，把等待中的帧继续分发并唤醒解码
+	void OnSubscriberPopped();
+
+	double GetFrameDurationMs() const;
+	void GetStats(FInVideoPlayerStats& OutStats) const;
+
+private:
+	FInVideoSource(const FString& VideoURL, const FString& Key, const FInVideoSourceOptions& Options);
+
+	struct FSubscriberEntry
+	{
+		int32 Id = INDEX_NONE;
+		FInVideoSourceSubscriber Subscriber;
+		// 拷贝分发用的暂存帧，Push 后换回队列里的旧槽位，内存循环复用
+		FInVideoFrame Staging;
+		// 收到的第一帧的帧号，首播从这里起算
+		int32 JoinFrame = INDEX_NONE;
+		// 上一次收到的帧号，正向播放时帧号变小说明源已回绕
+		int32 LastFrame = INDEX_NONE;
+		// 加入之后源已回绕，播放到加入帧之前即完成一遍
+		bool bWrapped = false;
+		bool bFirstPlayCompleted = false;
+	};
+	struct FScaledImage
+	{
+		FIntPoint Size = FIntPoint::ZeroValue;
+		cv::Mat Image;
+		uint64 Serial = 0;
+	};
+
+	// 以下需持有 m_Mutex
+	void FanOut();
+	bool DeliverHeldFrame();
+	bool IsActive(const FSubscriberEntry& Entry) const;
+	FIntPoint GetTargetSize(const FSubscriberEntry& Entry) const;
+	const cv::Mat& GetScaledImage(FIntPoint Size);
+	void CopyToSubscriber(FSubscriberEntry& Entry, const cv::Mat& Image);
+	void PruneScaledImages();
+	// 记录订阅者收到的帧，判断首播是否完成
+	void TrackFirstPlay(FSubscriberEntry& Entry);
+	void CompleteFirstPlay(FSubscriberEntry& Entry);
+	void UpdateDecoderPaused();
+	void UpdateDecoderThrottle();
+	// 所有订阅者都指定了尺寸时，解码器直接缩放到其中最大的尺寸，其余订阅者再从它缩小
+	void UpdateDecoderOutputSize();
+	FSubscriberEntry* FindSubscriber(int32 SubscriberId);
+
+	// 解码器回调，在解码线程触发
+	void HandleSeekApplied();
+	void HandleReachedEnd();
+
+private:
+	FString m_VideoURL;
+	FString m_Key;
+	FInVideoSourceOptions m_Options;
+	TAtomic<bool> m_bFailed = false;
+	// 反向播放不计入首播，需持有 m_Mutex
+	bool m_bReverse = false;
+
+	// 解码输出的队列，深度 1，分发跟不上时解码器等待
+	TInVideoRing<FInVideoFrame> m_Ring;
+	TUniquePtr<FInVideoDecoder> m_Decoder;
+
+	mutable FCriticalSection m_Mutex;
+	// cv::Mat 不能按位搬移，条目单独分配，数组扩容时只移动指针
+	TArray<TUniquePtr<FSubscriberEntry>> m_Subscribers;
+	int32 m_NextSubscriberId = 0;
+	bool m_bStarted = false;
+	// 已从 m_Ring 取出、尚未分发完的帧
+	FInVideoFrame m_HeldFrame;
+	bool m_bHasHeldFrame = false;
+	// 每分发一帧加一，用于判断缩放结果是否属于当前帧
+	uint64 m_FrameSerial = 0;
+	TArray<TUniquePtr<FScaledImage>> m_ScaledImages;
+};
@@ -0,0 +1,232 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+#include "InVideoStats.generated.h"
+
+DECLARE_STATS_GROUP(TEXT("InVideo"), STATGROUP_InVideo, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Seek"), STAT_InVideo_Seek, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Loop Count"), STAT_InVideo_LoopCount, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Last Loop Hitch (ms)"), STAT_InVideo_LoopHitchMs, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Worker Tick"), STAT_InVideo_WorkerTick, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode Scale"), STAT_InVideo_DecodeScale, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Upload Flush"), STAT_InVideo_UploadFlush, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Uploads Per Frame"), STAT_InVideo_UploadsPerFrame, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Superseded Uploads"), STAT_InVideo_SupersededUploads, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Record Queue Depth"), STAT_InVideo_RecordQueueDepth, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Record Dropped Frames"), STAT_InVideo_RecordDropped, STATGROUP_InVideo, INVIDEO_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Record Encode Lag (ms)"), STAT_InVideo_RecordEncodeLagMs, STATGROUP_InVideo, INVIDEO_API);
+
+// 单个播放器的运行统计，供蓝图查询
+USTRUCT(BlueprintType)
+struct INVIDEO_API FInVideoPlayerStats
+{
+	GENERATED_BODY()
+
+	// 解码帧队列中等待显示的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 FrameQueueDepth = 0;
+
+	// 帧队列满时被覆盖的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 FrameQueueDropped = 0;
+
+	// 是否已建立关键帧索引
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	bool bHasKeyframeIndex = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 SeekCount = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float LastSeekMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float AverageSeekMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float MaxSeekMs = 0.0f;
+
+	// 回绕到第 0 帧的次数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 LoopCount = 0;
+
+	// 回绕时最后一帧到第 0 帧的显示间隔超出正常帧间隔的部分
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float LastLoopHitchMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float MaxLoopHitchMs = 0.0f;
+
+	// 实际显示时刻与时钟计划时刻之差的绝对值分布，分桶上界依次为 1/2/4/8/16/33 ms，最后一桶为 33 ms 以上
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	TArray<int32> PresentJitterHistogram;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 PresentedFrames = 0;
+
+	// 下一帧也已到期而被跳过的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 LateDroppedFrames = 0;
+
+	// 新帧迟到导致上一帧多停留的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 RepeatedFrames = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float MeanAbsJitterMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float MaxJitterMs = 0.0f;
+
+	// 显示误差的滑动平均，持续偏离 0 说明显示节奏在漂移
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float ClockDriftMs = 0.0f;
+
+	// 不含暂停时间的实测显示帧率
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float MeasuredFps = 0.0f;
+
+	// 直播模式：解码端用 grab 丢弃的积压帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 LiveDrainedFrames = 0;
+
+	// 直播模式：显示端只取最新帧而跳过的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 LiveSkippedFrames = 0;
+
+	// 直播模式：最近一帧的端到端延迟估计 (ms)
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float LiveLatencyMs = 0.0f;
+
+	// true 表示延迟基于源提供的绝对采集时间；false 表示相对于会话内最小延迟的增量估计
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	bool bLiveLatencyAbsolute = false;
+
+	// 直播画面超过阈值未更新或延迟超过阈值
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	bool bLiveStale = false;
+
+	// 网络流断流后正在重连
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	bool bReconnecting = false;
+
+	// 当前这轮重连已尝试的次数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 ReconnectAttempt = 0;
+
+	// 成功重连的总次数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 ReconnectCount = 0;
+
+	// 共享同一解码源的控件数（含自身），解码和网络会话只有一份
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 SourceViewCount = 0;
+
+	// 控件最近是否被绘制且未被标记为遮挡
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	bool bVisible = true;
+
+	// 控件最近一次绘制时在屏幕上的像素尺寸
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	FIntPoint OnScreenSize = FIntPoint::ZeroValue;
+
+	// 不可见节流期间只 grab 或直接跳过、没有输出的帧数（共享源为所有控件合计）
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 ThrottledFrames = 0;
+
+	// 不可见期间按 OffscreenFps 省掉的纹理上传次数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 OffscreenSkippedUploads = 0;
+
+	// 尺寸变化后等待游戏线程从纹理池取得新纹理期间跳过的上传次数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 SurfacePendingFrames = 0;
+
+	// 渲染线程取走之前被更新的帧替换、没有上传的帧数（显示快于引擎帧率时出现）
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	int32 SupersededUploads = 0;
+
+	// StartPlay（预加载时为 PlayPreloaded）到首帧交给显示的耗时 (ms)
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo")
+	float FirstFrameLatencyMs = 0.0f;
+};
+
+// 多路同步组的运行统计
+USTRUCT(BlueprintType)
+struct INVIDEO_API FInVideoSyncGroupStats
+{
+	GENERATED_BODY()
+
+	// 是否在使用 VideoCapture::waitAny（仅 V4L2 后端支持），否则为单线程依次 grab
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	bool bUsingWaitAny = false;
+
+	// 各路时间戳是否为源提供的绝对时间，否则为本机到达时间
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	bool bAbsoluteTimestamps = false;
+
+	// 已同时显示的帧组数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	int32 FrameSets = 0;
+
+	// 组内时间戳跨度超过容差的帧组数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	int32 MisalignedSets = 0;
+
+	// 对齐时被跳过的旧帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	int32 SkippedFrames = 0;
+
+	// 渲染线程取走之前被下一组替换、没有上传的成员帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	int32 SupersededUploads = 0;
+
+	// 最近一组的时间戳跨度 (ms)
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	float LastSpreadMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Sync")
+	float MaxSpreadMs = 0.0f;
+};
+
+// 场景录制的运行统计
+USTRUCT(BlueprintType)
+struct INVIDEO_API FInRecordStats
+{
+	GENERATED_BODY()
+
+	// 等待编码的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 QueueDepth = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 QueueCapacity = 0;
+
+	// 已写入文件的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 EncodedFrames = 0;
+
+	// 录制队列满时按策略丢弃的帧数
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 DroppedFrames = 0;
+
+	// 采集端丢弃的帧数：回读全部在途或帧池耗尽
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 CaptureDroppedFrames = 0;
+
+	// 采集到写入文件的延迟 (ms)
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	float LastEncodeLagMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	float MaxEncodeLagMs = 0.0f;
+
+	// DegradeResolution 策略下当前的采集缩小级数，0 为原始分辨率，每级边长减半
+	UPROPERTY(BlueprintReadOnly, Category = "InVideo|Record")
+	int32 DownscaleLevel = 0;
+};
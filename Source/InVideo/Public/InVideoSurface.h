@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "HAL/CriticalSection.h"
+
+class UTexture;
+class FTextureResource;
+
+// 视频表面的种类：RGBA 上传写入 UTexture2D，Native 上传由着色器写入渲染目标
+enum class EInVideoSurfaceKind : uint8
+{
+	Texture,
+	RenderTarget
+};
+
+/**
+ * 视频纹理池：按种类、尺寸档位和 mip 级数缓存纹理，只在游戏线程访问。
+ * 分辨率变化或换流时纹理归还到池中供其他播放器复用，不再 AddToRoot，由池作为 FGCObject 持有引用。
+ * 归还的纹理要经过几帧冷却才会被复用或释放，保证旧画面的上传命令和 Brush 切换都已完成；
+ * 空闲纹理超过 InVideo.TexturePool.MaxFree 时立即释放渲染资源。
+ */
+class FInVideoTexturePool : public FGCObject
+{
+public:
+	static FInVideoTexturePool& Get();
+	// 模块卸载时调用，丢弃所有引用
+	static void Shutdown();
+
+	// 单级 mip 的纹理按 64 像素向上取整，帧只写入左上角；多级 mip 和渲染目标按实际尺寸
+	static FIntPoint GetSizeClass(EInVideoSurfaceKind Kind, FIntPoint Size, int32 NumMips);
+
+	// 从池中取一张空闲纹理，没有时新建。SizeClass 须来自 GetSizeClass
+	UTexture* Acquire(EInVideoSurfaceKind Kind, FIntPoint SizeClass, int32 NumMips);
+	void Release(UTexture* Texture);
+	// 释放冷却完毕的空闲纹理，只保留 MaxFree 张
+	void Trim(int32 MaxFree);
+	void LogStats() const;
+
+	// FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+	struct FEntry
+	{
+		TObjectPtr<UTexture> Texture;
+		EInVideoSurfaceKind Kind = EInVideoSurfaceKind::Texture;
+		FIntPoint SizeClass = FIntPoint::ZeroValue;
+		int32 NumMips = 1;
+		// 归还时的 GFrameCounter
+		uint64 ReleasedFrame = 0;
+	};
+	bool IsCooledDown(const FEntry& Entry) const;
+	UTexture* CreateTexture(EInVideoSurfaceKind Kind, FIntPoint SizeClass, int32 NumMips) const;
+	static void DestroyTexture(UTexture* Texture);
+
+	// 按归还先后排列，最早归还的在前
+	TArray<FEntry> m_Free;
+	TArray<FEntry> m_InUse;
+	int32 m_Created = 0;
+	int32 m_Reused = 0;
+	int32 m_Destroyed = 0;
+};
+
+/**
+ * 播放器持有的视频表面。显示线程用 Resolve 取得与帧尺寸匹配的纹理，
+ * 尺寸档位变化时向游戏线程异步申请，申请完成前 Resolve 返回无效视图、本帧跳过上传，显示线程从不等待游戏线程。
+ * 新纹理由显示线程在下一次 Resolve 时换上，旧纹理随即归还到池中。
+ */
+class FInVideoSurface : public TSharedFromThis<FInVideoSurface, ESPMode::ThreadSafe>
+{
+public:
+	struct FView
+	{
+		UTexture* Texture = nullptr;
+		FTextureResource* Resource = nullptr;
+		// 纹理的实际尺寸，可能大于帧尺寸
+		FIntPoint TextureSize = FIntPoint::ZeroValue;
+		int32 NumMips = 1;
+
+		bool IsValid() const { return nullptr != Resource; }
+		// 帧在纹理中所占的 UV 范围，纹理大于帧时内缩半个纹素，避免双线性采样读到边缘外的旧内容
+		FBox2f GetUVRegion(FIntPoint FrameSize) const;
+	};
+
+	explicit FInVideoSurface(EInVideoSurfaceKind Kind);
+	~FInVideoSurface();
+
+	// 显示线程调用
+	FView Resolve(FIntPoint FrameSize, int32 NumMips);
+	// 任意线程调用：纹理归还到池中，调用前须保证显示线程不再使用之前 Resolve 得到的视图
+	void Release();
+
+private:
+	struct FSlot
+	{
+		FView View;
+		FIntPoint SizeClass = FIntPoint::ZeroValue;
+	};
+	void OnAcquired(UTexture* Texture, FIntPoint SizeClass, int32 NumMips, uint32 RequestId);
+	static void ReleaseToPool(UTexture* Texture);
+
+	EInVideoSurfaceKind m_Kind;
+	FCriticalSection m_Mutex;
+	FSlot m_Current;
+	// 游戏线程已备好、等待显示线程换上的纹理
+	FSlot m_Ready;
+	bool m_bRequestPending = false;
+	FIntPoint m_RequestedClass = FIntPoint::ZeroValue;
+	int32 m_RequestedMips = 0;
+	// 每次申请或 Release 递增，过期的申请结果直接归还
+	uint32 m_RequestId = 0;
+};
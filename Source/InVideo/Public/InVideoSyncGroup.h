@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "HAL/CriticalSection.h"
+#include "InVideoDecoder.h"
+#include "InVideoStats.h"
+#include "InVideoWorkerPool.h"
+#include "InVideoWidget.h"
+#include "PreOpenCVHeaders.h"
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include "PostOpenCVHeaders.h"
+
+#include "InVideoSyncGroup.generated.h"
+
+/**
+ * 多路摄像头同步组：所有 VideoCapture 作为一个任务在工作线程池的 I/O 线程上读取，按时间戳对齐后整组显示。
+ * 后端支持时（OpenCV 4.6 只有 V4L2，Win64 的 MSMF/DSHOW/FFMPEG 都不支持）用 cv::VideoCapture::waitAny
+ * 同时等待所有流并只 grab 已就绪的流，不支持时在该任务里依次阻塞 grab，不占用解码/显示线程。
+ * 连续多轮所有流都读取失败（或 waitAny 长时间没有任何流就绪）时触发 Failed 并停止。
+ * 对齐：各路最新帧中最早的时间戳为参考时刻，每路取最接近参考时刻的帧；
+ * 整组的纹理更新整批提交给上传调度，同组画面在同一帧切换。
+ */
+class FInVideoSyncGroup
+{
+public:
+	struct FMember
+	{
+		FString VideoURL;
+		TWeakObjectPtr<UInVideoWidget> Widget;
+		int32 UploadBufferCount = 3;
+	};
+
+	FInVideoSyncGroup(TArray<FMember> Members, float ToleranceMs, FDelegatePlayFailed Failed);
+	~FInVideoSyncGroup();
+
+	void Start();
+	FInVideoSyncGroupStats GetStats() const;
+
+private:
+	// 每路最近的几帧，用于按时间戳挑选
+	static constexpr int32 MaxHistoryFrames = 4;
+	struct FStream
+	{
+		FString VideoURL;
+		double OpenTimeUs = 0.0;
+		// 固定数组的环形缓冲，cv::Mat 不随容器扩容搬移
+		FInVideoFrame Frames[MaxHistoryFrames];
+		double TimesMs[MaxHistoryFrames] = {};
+		int32 Head = 0;
+		int32 Count = 0;
+		int32 NextFrameIndex = 0;
+		TUniquePtr<VideoPlay> Player;
+	};
+
+	double Tick(double NowSeconds);
+	bool OpenStreams();
+	bool OpenStream(int32 Index);
+	// 返回本次取到的帧数
+	int32 GrabReady();
+	// 本轮没有取到任何帧，达到失败上限时返回 true
+	bool RecordEmptyRound(double NowSeconds);
+	void Retrieve(int32 Index);
+	void TryPublish();
+	void NotifyFailed();
+
+private:
+	TArray<TUniquePtr<FStream>> m_Streams;
+	// 与 m_Streams 一一对应，waitAny 直接使用这个数组
+	std::vector<cv::VideoCapture> m_Captures;
+	float m_ToleranceMs = 20.0f;
+	FDelegatePlayFailed m_Failed;
+	FInVideoWorkerPool::FTaskHandle m_Task;
+	TAtomic<bool> m_Stopping = false;
+	bool m_bOpened = false;
+	bool m_bUseWaitAny = true;
+	bool m_bAbsoluteTime = false;
+	// 依次 grab 时连续所有流都失败的轮数
+	int32 m_FailedRounds = 0;
+	// 最近一次取到帧的时刻，waitAny 超时不算失败，按时长判断
+	double m_LastFrameSeconds = 0.0;
+	double m_LastReferenceMs = -TNumericLimits<double>::Max();
+	VideoPlay::FRenderBatch m_RenderBatch;
+
+	mutable FCriticalSection m_StatsMutex;
+	int32 m_FrameSets = 0;
+	int32 m_MisalignedSets = 0;
+	int32 m_SkippedFrames = 0;
+	int32 m_SupersededUploads = 0;
+	float m_LastSpreadMs = 0.0f;
+	float m_MaxSpreadMs = 0.0f;
+};
+
+// 蓝图使用的同步组：添加成员后 StartGroup，各成员控件显示对应的流
+UCLASS(BlueprintType)
+class INVIDEO_API UInVideoSyncGroup : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Sync")
+	static UInVideoSyncGroup* CreateSyncGroup();
+
+	// 添加一路流，VideoURL 为纯数字时按摄像头序号打开
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Sync")
+	void AddStream(UInVideoWidget* Widget, const FString& VideoURL);
+
+	// ToleranceMs：组内时间戳跨度超过该值时计为未对齐
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Sync")
+	void StartGroup(FDelegatePlayFailed Failed, float ToleranceMs = 20.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Sync")
+	void StopGroup();
+
+	UFUNCTION(BlueprintPure, Category = "InVideo|Sync")
+	FInVideoSyncGroupStats GetGroupStats() const;
+
+	virtual void BeginDestroy() override;
+
+private:
+	TArray<FInVideoSyncGroup::FMember> m_Members;
+	TUniquePtr<FInVideoSyncGroup> m_Group;
+};
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "InVideoBufferPool.h"
+#include "InVideoPlaneUpload.h"
+
+class FTexture2DResource;
+class FTextureRenderTargetResource;
+
+// 一次纹理上传，由显示线程填写，渲染线程执行。Texture 和 Target 二选一
+struct FInVideoUpload
+{
+	// 提交者（播放器），同一提交者每帧只保留最新的一次上传
+	const void* Owner = nullptr;
+	// RGBA 上传：Buffer 内从第 0 级开始各级 mip 依次紧密排列，每像素 4 字节
+	FTexture2DResource* Texture = nullptr;
+	int32 NumMips = 1;
+	// Native 上传：平面数据上传到 Planes 后由着色器转换到 Target
+	TSharedPtr<FInVideoPlaneTextures, ESPMode::ThreadSafe> Planes;
+	FTextureRenderTargetResource* Target = nullptr;
+	EInVideoPlaneLayout Layout = EInVideoPlaneLayout::PackedBGR;
+	int32 Width = 0;
+	int32 Height = 0;
+	// 执行后释放引用，缓冲区回到播放器的上传缓冲池
+	TInVideoBufferPool<TArray<uint8>>::FBufferRef Buffer;
+
+	void Execute(FRHICommandListImmediate& RHICmdList) const;
+};
+
+/**
+ * 全局上传调度：所有播放器的上传先进入待提交列表，游戏线程每帧结束时只发一条渲染命令统一执行。
+ * 待提交列表对每个提交者相当于一个只存最新帧的信箱：渲染线程取走之前再次提交会直接替换，
+ * 被替换的帧不会上传，缓冲区立即回到池中。
+ * 待提交列表和执行列表在渲染线程上交换，容量跨帧保留，稳态下提交上传不分配内存。
+ */
+class FInVideoUploadScheduler
+{
+public:
+	// 模块加载时创建并注册帧结束回调，卸载时等待渲染线程执行完再销毁
+	static void Startup();
+	static void Shutdown();
+	static FInVideoUploadScheduler& Get();
+
+	// 任意线程调用，返回 true 表示替换了同一提交者尚未执行的上传
+	bool Submit(FInVideoUpload&& Upload);
+	// 整批进入同一帧的渲染命令（同步组整组切换），提交后 Batch 清空但保留容量。返回被替换的上传数
+	int32 Submit(TArray<FInVideoUpload>& Batch);
+
+private:
+	bool SubmitLocked(FInVideoUpload&& Upload);
+	void OnEndFrame();
+	void Flush_RenderThread(FRHICommandListImmediate& RHICmdList);
+
+	FCriticalSection m_Mutex;
+	TArray<FInVideoUpload> m_Pending;
+	// 本帧的渲染命令已发出、尚未在渲染线程取走待提交列表
+	bool m_bFlushQueued = false;
+	// 只在渲染线程使用
+	TArray<FInVideoUpload> m_Executing;
+	FDelegateHandle m_EndFrameHandle;
+};
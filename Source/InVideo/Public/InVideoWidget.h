@@ -4,10 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
-#include "HAL/Runnable.h"
 #include "Engine/Texture2D.h"
 #include "Components/Image.h"
 #include "HAL/PlatformAtomics.h"
+#include "InVideoRing.h"
+#include "InVideoDecoder.h"
+#include "InVideoSource.h"
+#include "InVideoBufferPool.h"
+#include "InVideoPlaneUpload.h"
+#include "InVideoStats.h"
+#include "InVideoClock.h"
+#include "InVideoWorkerPool.h"
+#include "InVideoSurface.h"
+#include "InVideoUploadScheduler.h"
 #include "PreOpenCVHeaders.h"
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
@@ -21,11 +30,29 @@ DECLARE_DYNAMIC_DELEGATE(FDelegatePlayFailed);
 DECLARE_DYNAMIC_DELEGATE(FDelegateFirstFrame);
 DECLARE_DYNAMIC_DELEGATE(FDelegateFirstPlayCompleted);
 DECLARE_DYNAMIC_DELEGATE(FDelegateVideoFileNotFound);
+DECLARE_DYNAMIC_DELEGATE(FDelegateLiveStale);
+DECLARE_DYNAMIC_DELEGATE_OneParam(FDelegateReconnecting, int32, Attempt);
+DECLARE_DYNAMIC_DELEGATE(FDelegateRecovered);
 
+// 控件不可见（折叠、隐藏、滚出视口或标记为遮挡）时播放器的处理方式
+UENUM(BlueprintType)
+enum class EInVideoOffscreenPolicy : uint8
+{
+	// 照常解码和上传
+	KeepPlaying,
+	// 时间轴照常推进，解码输出和纹理上传降到 OffscreenFps
+	ReduceRate,
+	// 文件源只解码关键帧（需要关键帧索引），直播源同 ReduceRate
+	KeyframesOnly,
+	// 文件源暂停在当前位置；直播源只 grab 保持网络会话，恢复可见时立即显示最新帧
+	Suspend
+};
 
-class VideoPlay :public FRunnable
+class VideoPlay
 {
 public:
+	using FUploadBufferPool = TInVideoBufferPool<TArray<uint8>>;
+	using FRenderBatch = TArray<FInVideoUpload>;
 
 
 	void StartPlay(const FString VideoURL, FDelegatePlayFailed Failed, FDelegateFirstFrame FirstFrame,
@@ -34,9 +61,15 @@ public:
 	void BindVideoFileNotFoundDelegate(FDelegateVideoFileNotFound Delegate);
 	void NotifyFirstPlayCompleted();
 	void NotifyVideoFileNotFound();
+	void BindLiveStaleDelegate(FDelegateLiveStale Delegate);
+	void BindReconnectingDelegate(FDelegateReconnecting Delegate);
+	void BindRecoveredDelegate(FDelegateRecovered Delegate);
 	void StopPlay();
 	FDelegateFirstPlayCompleted m_FirstPlayCompleted;
 	FDelegateVideoFileNotFound m_VideoFileNotFound;
+	FDelegateLiveStale m_LiveStale;
+	FDelegateReconnecting m_Reconnecting;
+	FDelegateRecovered m_Recovered;
 	void SetPlayRate(float Rate);
 	void SetReverse(bool bReverse);
 	void SetResolution(const FVector2D& NewResolution);
@@ -44,23 +77,73 @@ public:
 	void ContinuePlay(int32 FrameIndex = -1);
 	void PausePlay();
 	void ResumePlay();
-public:
-	bool Init() override;
-	uint32 Run() override;
-	void Stop() override;
-	void Exit() override;
+	void SetFrameQueue(int32 Depth, EInVideoQueueFullPolicy Policy);
+	void SetUploadBufferCount(int32 Count);
+	void SetUploadMode(EInVideoUploadMode Mode);
+	void SetReverseCacheMemory(int32 MegaBytes);
+	void SetGaplessLoop(bool bEnable, int32 HeadFrames);
+	void SetLiveMode(bool bLive, int32 OpenTimeoutMs, int32 ReadTimeoutMs, int32 StaleThresholdMs);
+	void SetReconnect(bool bEnable, float InitialDelaySeconds, float MaxDelaySeconds, int32 MaxAttempts);
+	void SetShareSource(bool bShare);
+	// 预加载：打开并解码，首帧上传到自己的纹理但不设置控件 Brush、不推进时钟，其余帧留在队列中，Activate 后开始播放
+	void SetPreroll(bool bPreroll);
+	// 按配置文件选择视频时使用的模型序号，INDEX_NONE 表示 OwnerOverlay 的当前模型
+	void SetProfileModelIndex(int32 ModelIndex);
+	// 切换到预加载的播放器时沿用控件上已绑定的回调
+	void CopyDelegatesFrom(const VideoPlay& Other);
+	// 预加载的首帧是否已上传
+	bool IsPrerollReady() const;
+	// 游戏线程调用：结束预加载，首帧已上传时当帧设置 Brush
+	void Activate();
+	void SetOffscreenPolicy(EInVideoOffscreenPolicy Policy, float OffscreenFps);
+	// MipCount > 1 时每帧在 CPU 上盒式下采样生成 mip 链（仅 RGBA 上传）；bFitToWidget 时未指定分辨率的输出尺寸跟随控件像素尺寸
+	void SetTextureOptions(int32 MipCount, bool bFitToWidget);
+	// 控件被绘制时在游戏线程调用，一段时间没有绘制视为不可见
+	void ReportPainted(FIntPoint PixelSize);
+	// Slate 不做遮挡剔除，被其他控件完全盖住时由调用方标记
+	void SetOccluded(bool bOccluded);
+	// 同步组成员：不创建解码源和显示任务，由同步组在对齐后调用 PresentSyncedFrame
+	void StartSyncMember(const FString& VideoURL, UInVideoWidget* widget);
+	// 显示一帧，上传追加到 Batch，由调用者整批提交给上传调度，同组的纹理在同一帧更新
+	void PresentSyncedFrame(FInVideoFrame& Frame, FRenderBatch& Batch);
+	FInVideoPlayerStats GetStats() const;
 private:
+	// 工作线程池的调度入口，返回下一次执行的时刻
+	double Tick(double NowSeconds);
+	double PresentStep(double NowSeconds);
+	double PresentLive(double NowSeconds);
+	// 预加载期间只取出并上传首帧
+	double PrerollStep(double NowSeconds);
+	// 取出一帧并唤醒解码任务
+	bool PopFrame(FInVideoFrame& OutFrame);
+	FIntPoint GetOutputSize() const;
+	// 根据最近的绘制时间更新可见状态，变化时调整解码源的节流
+	void UpdateVisibility(double NowSeconds);
+	// 不可见时按 OffscreenFps 限制上传
+	bool ShouldUpload(double NowSeconds);
+	// 跟随控件尺寸时，屏幕尺寸变化超过阈值再调整解码源的输出尺寸
+	void UpdateFitToWidget();
+	// 交给上传调度在本帧结束时执行，未执行的上一帧会被替换；同步组显示期间追加到批次
+	void SubmitUpload(FInVideoUpload&& Upload);
 	void UpdateTexture();
-	void UpdateTextureRegions(UTexture2D* Texture, int32 MipIndex, uint32 NumRegions, FUpdateTextureRegion2D* Regions, uint32 SrcPitch, uint32 SrcBpp, uint8* SrcData, bool bFreeData);
+	void UpdatePlanes(FUploadBufferPool::FBufferRef UploadBuffer);
+	// 纹理对象或显示区域变化时才在游戏线程设置 Brush
+	void UpdateBrush(UTexture* Texture, const FBox2f& UVRegion);
 	void NotifyFailed();
 	void NotifyFirstFrame();
+	void TrackLoopHitch(double TargetIntervalMs);
+	void UpdateLiveLatency();
+	void NotifyLiveStale();
+	void NotifyReconnecting(int32 Attempt);
+	void NotifyRecovered();
 public:
-	UTexture2D* VideoTexture = nullptr;
 	TWeakObjectPtr<UInVideoWidget> m_widget = nullptr;
 	bool m_bFirstPlayCompleted = false;
 
 private:
-	FRunnableThread* m_Thread = nullptr;
+	FInVideoWorkerPool::FTaskHandle m_PresentTask;
+	FRenderBatch* m_RenderBatch = nullptr;
+	bool m_bWasPaused = false;
 	TAtomic<bool> m_Stopping = false;
 	FString m_VideoURL;
 	FString m_DraggerVideoURL;//这里需要测试一下
@@ -72,25 +155,104 @@ private:
 	bool m_bPaused = false;
 	bool m_bCustomResolution = false;
 	int32 m_CurrentFrameIndex = 0;
-	int32 m_TotalFrames = 0;
 	bool m_RealMode = true;
-	float m_SleepSecond = 1 / 50;
-	FDateTime m_LastReadTime = FDateTime::Now();
-	TArray<uint8> m_PixelDataBuffer;
+	// 每个实例独立的上传缓冲池，缓冲区在渲染命令执行完后才回收
+	int32 m_UploadBufferCount = 3;
+	TSharedPtr<FUploadBufferPool, ESPMode::ThreadSafe> m_UploadBufferPool;
+
+	// Native 上传模式：平面纹理由渲染线程持有，着色器转换到 m_PlaneTarget
+	EInVideoUploadMode m_UploadMode = EInVideoUploadMode::RGBA;
+	int32 m_ReverseCacheMB = 256;
+	// 无缝循环
+	bool m_bGaplessLoop = false;
+	int32 m_LoopHeadFrames = 10;
+	// 回绕卡顿统计，显示线程写入
+	double m_LastPresentSeconds = 0.0;
+	int32 m_LastPresentedIndex = INDEX_NONE;
+	mutable FCriticalSection m_StatsMutex;
+	int32 m_LoopCount = 0;
+	float m_LastLoopHitchMs = 0.0f;
+	float m_MaxLoopHitchMs = 0.0f;
+	// 低延迟直播：队列最多 2 帧，总是显示最新帧
+	bool m_bLiveMode = false;
+	bool m_bLiveActive = false;
+	int32 m_LiveOpenTimeoutMs = 5000;
+	int32 m_LiveReadTimeoutMs = 3000;
+	int32 m_LiveStaleThresholdMs = 2000;
+	double m_LastLivePresentSeconds = 0.0;
+	// 无绝对时间时 (解码时刻 - PTS) 的会话最小值，作为延迟基线
+	double m_LiveBaselineOffsetMs = TNumericLimits<double>::Max();
+	int32 m_LiveSkippedFrames = 0;
+	float m_LiveLatencyMs = 0.0f;
+	bool m_bLiveLatencyAbsolute = false;
+	bool m_bLiveStale = false;
+	// 重连成功后 PTS 从头开始，延迟基线需要重建
+	TAtomic<bool> m_bResetLiveBaseline = false;
+	// 断流重连
+	bool m_bAutoReconnect = true;
+	float m_ReconnectInitialDelay = 0.5f;
+	float m_ReconnectMaxDelay = 30.0f;
+	int32 m_ReconnectMaxAttempts = 0;
+	// 不可见节流：绘制时间由游戏线程写入，可见状态只在显示线程维护
+	EInVideoOffscreenPolicy m_OffscreenPolicy = EInVideoOffscreenPolicy::KeepPlaying;
+	float m_OffscreenFps = 2.0f;
+	TAtomic<uint64> m_LastPaintCycles = 0;
+	TAtomic<bool> m_bOccluded = false;
+	bool m_bVisible = true;
+	double m_NextOffscreenUploadSeconds = 0.0;
+	FIntPoint m_OnScreenSize = FIntPoint::ZeroValue;
+	int32 m_OffscreenSkippedUploads = 0;
+	// 纹理 mip 和控件尺寸
+	int32 m_TextureMipCount = 1;
+	bool m_bFitToWidget = false;
+	FIntPoint m_FitOutputSize = FIntPoint::ZeroValue;
+	TSharedPtr<FInVideoPlaneTextures, ESPMode::ThreadSafe> m_PlaneTextures;
+	// 显示用的纹理（RGBA 上传）或渲染目标（Native 上传），从全局纹理池按尺寸档位取得
+	TSharedPtr<FInVideoSurface, ESPMode::ThreadSafe> m_Surface;
+	// 等待游戏线程准备新尺寸纹理期间跳过的上传
+	int32 m_SurfacePendingFrames = 0;
+	// 渲染线程取走之前被新帧替换的上传
+	int32 m_SupersededUploads = 0;
+	// 最近一次设置到控件 Brush 的纹理和 UV 范围，显示线程维护
+	UTexture* m_BrushTexture = nullptr;
+	FBox2f m_BrushUVRegion = FBox2f(FVector2f::ZeroVector, FVector2f(1.0f, 1.0f));
+	// 预加载
+	TAtomic<bool> m_bPreroll = false;
+	bool m_bPrerollShown = false;
+	bool m_bWasPreroll = false;
+	// Activate 时首帧尚未上传，上传后不论纹理是否变化都要设置 Brush
+	TAtomic<bool> m_bForceBrush = false;
+	int32 m_ProfileModelIndex = INDEX_NONE;
+	// 以下由 m_StatsMutex 保护：预加载首帧所在的纹理，以及开始播放（或 Activate）到首帧的耗时
+	UTexture* m_PrerollTexture = nullptr;
+	FBox2f m_PrerollUVRegion = FBox2f(FVector2f::ZeroVector, FVector2f(1.0f, 1.0f));
+	double m_StartSeconds = 0.0;
+	float m_FirstFrameLatencyMs = 0.0f;
 	FDelegatePlayFailed m_Failed;
 	FDelegateFirstFrame m_FirstFrame;
 	bool m_BFirstFrame = false;
-	class WrapOpenCv
-	{
-	public:
-		cv::VideoCapture m_Stream;
-		cv::Mat m_Frame;
-	};
-	WrapOpenCv* m_WrapOpenCv = nullptr;
-
-	FVector2D m_VideoSize = FVector2D(0, 0);
-	FUpdateTextureRegion2D* m_VideoUpdateTextureRegion = nullptr;
-	FTexture2DResource* m_Texture2DResource = nullptr;
+
+	// 解码线程写入、显示线程读取的帧队列
+	int32 m_FrameQueueDepth = 4;
+	EInVideoQueueFullPolicy m_FrameQueuePolicy = EInVideoQueueFullPolicy::Block;
+	TInVideoRing<FInVideoFrame> m_FrameRing;
+	// 解码源，相同 URL 和解码选项的控件共享
+	bool m_bShareSource = false;
+	TSharedPtr<FInVideoSource, ESPMode::ThreadSafe> m_Source;
+	int32 m_SubscriberId = INDEX_NONE;
+	// 当前正在显示的帧，Pop 时与队列槽位交换
+	FInVideoFrame m_PresentFrame;
+	// 已从队列取出、等待显示时刻的帧
+	FInVideoFrame m_PendingFrame;
+	bool m_bHasPendingFrame = false;
+	double m_PendingDueSeconds = 0.0;
+	TAtomic<bool> m_bDiscardPending = false;
+	// 显示时钟，网络实时流不使用
+	FInVideoClock m_Clock;
+	bool m_bPacedByClock = true;
+
+	// 解码源未能按目标尺寸输出时的缩放结果，跨帧复用
+	cv::Mat m_ResizedFrame;
 	TArray64<FColor> Data;
 };
 
@@ -127,6 +289,15 @@ public:
 	UFUNCTION(BlueprintCallable,Category = "InVideo")
 	void BindOnVideoFileNotFound(FDelegateVideoFileNotFound Delegate);
 
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Live")
+	void BindOnLiveStale(FDelegateLiveStale Delegate);
+
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Live")
+	void BindOnReconnecting(FDelegateReconnecting Delegate);
+
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Live")
+	void BindOnRecovered(FDelegateRecovered Delegate);
+
 
 	//已经废弃
 	UFUNCTION(BlueprintCallable,Category = "InVideo")
@@ -141,15 +312,124 @@ public:
 	UFUNCTION(BlueprintCallable,Category = "Invideo")
 	void LoadVideoURLFromProfile(FString PlayCase);
 
+	UFUNCTION(BlueprintPure, Category = "InVideo")
+	FInVideoPlayerStats GetPlayerStats() const;
+
+	// 预加载下一段视频：后台打开并解码，首帧上传到独立纹理但不显示，之后调用 PlayPreloaded 立即切换。
+	// VideoURL 与 StartPlay 相同为配置文件的播放用例，ModelIndex 指定下一个模型，-1 表示当前模型
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Playlist")
+	void PreloadNext(const FString VideoURL, FDelegatePlayFailed Failed, FDelegateFirstFrame FirstFrame,
+		const bool RealMode = true, const int Fps = 25, int32 ModelIndex = -1);
+
+	// 停止当前视频并切换到预加载的视频，没有预加载时返回 false
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Playlist")
+	bool PlayPreloaded();
+
+	UFUNCTION(BlueprintCallable, Category = "InVideo|Playlist")
+	void CancelPreload();
+
+	// 预加载的首帧已上传，此时切换没有黑帧
+	UFUNCTION(BlueprintPure, Category = "InVideo|Playlist")
+	bool IsPreloadReady() const;
+
+	// 控件被其他控件完全遮挡时设置为 true，按 OffscreenPolicy 节流；折叠、隐藏和滚出视口会自动检测
+	UFUNCTION(BlueprintCallable, Category = "InVideo")
+	void SetOccluded(bool bOccluded);
+
 	UPROPERTY(BlueprintReadWrite, Meta = (BindWidget),Category = "InVideo")
 	UImage* ImageVideo;
 
 	UPROPERTY(BlueprintReadWrite,Category = "Invideo")
 	TObjectPtr<class UMDOverlayWidget> OwnerOverlay;
+
+	// 解码帧队列深度，用于吸收解码抖动
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo", meta = (ClampMin = "1", ClampMax = "64"))
+	int32 FrameQueueDepth = 4;
+
+	// 解码帧队列满时的策略
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo")
+	EInVideoQueueFullPolicy FrameQueueFullPolicy = EInVideoQueueFullPolicy::Block;
+
+	// 纹理上传缓冲区数量，渲染线程积压时超出的帧直接跳过上传
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo", meta = (ClampMin = "1", ClampMax = "8"))
+	int32 UploadBufferCount = 3;
+
+	// RGBA: CPU 转换后上传; Native: 上传解码器原生 YUV/BGR 平面，由着色器转换颜色
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo")
+	EInVideoUploadMode UploadMode = EInVideoUploadMode::RGBA;
+
+	// 非实时反向播放时解码缓存的内存上限 (MB)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo", meta = (ClampMin = "16"))
+	int32 ReverseCacheMemoryMB = 256;
+
+	// 非实时正向循环播放时缓存片头，回绕时从内存交出，避免回到开头的 Seek 卡顿
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo")
+	bool bGaplessLoop = false;
+
+	// 无缝循环缓存的片头帧数，需覆盖后台重新定位的耗时
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo", meta = (ClampMin = "1", ClampMax = "120", EditCondition = "bGaplessLoop"))
+	int32 LoopHeadFrames = 10;
+
+	// RTSP 等网络流的低延迟直播模式：只缓冲 1~2 帧，总是显示最新解码的帧
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live")
+	bool bLiveMode = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "100", EditCondition = "bLiveMode"))
+	int32 LiveOpenTimeoutMs = 5000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "100", EditCondition = "bLiveMode"))
+	int32 LiveReadTimeoutMs = 3000;
+
+	// 画面超过该时长未更新或端到端延迟超过该值时触发 OnLiveStale
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "100", EditCondition = "bLiveMode"))
+	int32 LiveStaleThresholdMs = 2000;
+
+	// 网络直播流断流时自动重连，重连期间保留最后一帧画面
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live")
+	bool bAutoReconnect = true;
+
+	// 第一次重连前的等待时间，之后每次翻倍，并带随机抖动
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "0.01", EditCondition = "bAutoReconnect"))
+	float ReconnectInitialDelaySeconds = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "0.01", EditCondition = "bAutoReconnect"))
+	float ReconnectMaxDelaySeconds = 30.0f;
+
+	// 0 表示一直重连，用尽后触发播放失败
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Live", meta = (ClampMin = "0", EditCondition = "bAutoReconnect"))
+	int32 ReconnectMaxAttempts = 0;
+
+	// 与播放同一 URL（且解码选项、初始播放方向相同）的其他控件共享一个解码器，网络流只建立一个会话。
+	// 共享时 Seek 和播放方向对所有控件生效，暂停各自独立；中途加入的控件从共享源当前的位置开始显示
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo")
+	bool bShareDecoder = false;
+
+	// 控件不可见时的节流方式，默认照常播放；共享解码器时任何一个控件可见就全速解码
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Offscreen")
+	EInVideoOffscreenPolicy OffscreenPolicy = EInVideoOffscreenPolicy::KeepPlaying;
+
+	// 视频纹理的 mip 级数，大于 1 时每帧用盒式滤波生成缩小的 mip，缩略图墙缩小显示时不再混叠。仅 RGBA 上传模式
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Texture", meta = (ClampMin = "1", ClampMax = "6"))
+	int32 TextureMipCount = 1;
+
+	// 未调用 SetVideoResolution 时按控件在屏幕上的像素尺寸解码和上传（只缩小），纹理与显示尺寸一一对应
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Texture")
+	bool bFitTextureToWidget = false;
+
+	// ReduceRate/KeyframesOnly 时不可见控件的帧率上限
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "InVideo|Offscreen", meta = (ClampMin = "0.1", ClampMax = "30"))
+	float OffscreenFps = 2.0f;
 public:
 	virtual void NativeConstruct() override;
 	virtual void NativeDestruct() override;
+	virtual int32 NativePaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 
 private:
+	// 按控件属性创建并配置播放器
+	TUniquePtr<VideoPlay> CreateVideoPlay() const;
+
 	TUniquePtr<VideoPlay> m_VideoPlayPtr;
+	// 预加载中的下一段视频
+	TUniquePtr<VideoPlay> m_PreloadPtr;
 };
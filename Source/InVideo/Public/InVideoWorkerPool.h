@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Event.h"
+
+/**
+ * 所有播放器共享的工作线程池。
+ * 解码和显示都拆成不阻塞的 Tick，由固定数量的工作线程按各任务下一次的到期时间调度，
+ * 线程数随 CPU 核数而不是控件数量增长。
+ * 每个工作线程有自己的任务队列，自身队列没有到期任务时从同组其他队列窃取已到期的任务。
+ * 会阻塞在采集 I/O 上的任务（网络流、采集卡的 open/grab）用 RegisterBlocking 注册到单独的 I/O 线程组，
+ * 调度方式相同，不占用解码/显示线程。I/O 线程数同样有上限 (InVideo.IOThreads)，
+ * 网络流多于 I/O 线程时轮流 grab；大量流同时断开时，open/grab 的超时会占住 I/O 线程，其余网络流的读取随之推迟。
+ */
+class FInVideoWorkerPool
+{
+public:
+	// 执行一次工作，返回下一次希望执行的 FPlatformTime::Seconds 时刻；返回负数表示任务结束
+	using FTickFunction = TFunction<double(double NowSeconds)>;
+
+	// 任务所属的线程组
+	enum class EGroup : uint8
+	{
+		// 解码/显示，Tick 不阻塞
+		Compute,
+		// 采集 I/O，Tick 可以阻塞到 I/O 超时
+		BlockingIO,
+		Num
+	};
+
+	struct FTask
+	{
+		FString Name;
+		FTickFunction Tick;
+		EGroup Group = EGroup::Compute;
+		TAtomic<double> DueSeconds = 0.0;
+		TAtomic<bool> bRunning = false;
+		TAtomic<bool> bRemoved = false;
+		// Tick 执行期间被唤醒，执行完后立即再调度
+		TAtomic<bool> bWakeRequested = false;
+		// 所在工作线程在组内的下标
+		TAtomic<int32> OwnerWorker = 0;
+		TAtomic<uint32> RunningThreadId = 0;
+	};
+	using FTaskHandle = TSharedPtr<FTask, ESPMode::ThreadSafe>;
+
+	static FInVideoWorkerPool& Get();
+	// 模块卸载时停止所有工作线程
+	static void Shutdown();
+
+	// 注册后立即参与调度
+	FTaskHandle Register(const FString& Name, FTickFunction Tick);
+	// 注册到 I/O 线程组，Tick 可以阻塞；Unregister/Wake 与普通任务相同。I/O 线程在第一次注册时创建
+	FTaskHandle RegisterBlocking(const FString& Name, FTickFunction Tick);
+	// 移除任务并等待正在执行的 Tick 结束，返回后可以安全销毁 Tick 引用的对象
+	void Unregister(const FTaskHandle& Task);
+	// 让任务尽快执行，例如队列里来了新帧
+	void Wake(const FTaskHandle& Task);
+
+	int32 GetNumWorkers() const { return m_Groups[(int32)EGroup::Compute].Workers.Num(); }
+
+	~FInVideoWorkerPool();
+
+private:
+	struct FWorkerGroup;
+
+	class FWorker : public FRunnable
+	{
+	public:
+		FWorker(FInVideoWorkerPool& InPool, FWorkerGroup& InGroup, int32 InIndex);
+		virtual ~FWorker();
+
+		uint32 Run() override;
+		void Stop() override;
+
+		FInVideoWorkerPool& Pool;
+		FWorkerGroup& Group;
+		int32 Index = 0;
+		FCriticalSection Mutex;
+		TArray<FTaskHandle> Tasks;
+		FEvent* WakeEvent = nullptr;
+		FRunnableThread* Thread = nullptr;
+		TAtomic<bool> bStopping = false;
+		// 正在执行 Tick，期间本队列到期的任务只能被窃取
+		TAtomic<bool> bBusy = false;
+	};
+
+	// 一组工作线程，任务只在组内分配和窃取
+	struct FWorkerGroup
+	{
+		TArray<TUniquePtr<FWorker>> Workers;
+		TAtomic<int32> NextWorker = 0;
+	};
+
+	explicit FInVideoWorkerPool(int32 NumWorkers);
+
+	void StartGroup(EGroup Group, int32 NumWorkers, const TCHAR* ThreadName);
+	FTaskHandle RegisterIn(EGroup Group, const FString& Name, FTickFunction Tick);
+	// 从本线程队列取一个已到期的任务，没有时返回空并给出最早的到期时刻
+	FTaskHandle ClaimOwn(FWorker& Worker, double NowSeconds, double& OutEarliestDue);
+	// 从同组其他线程的队列窃取一个已到期的任务并移到本线程队列，没有时给出忙碌线程上最早可窃取的到期时刻
+	FTaskHandle Steal(FWorker& Worker, double NowSeconds, double& OutEarliestStealable);
+	void Execute(const FTaskHandle& Task, double NowSeconds);
+	void RemoveFromWorker(const FTaskHandle& Task);
+	// 任务所在线程正忙时叫醒同组一个空闲线程来窃取
+	void WakeIdleWorker(FWorkerGroup& Group, int32 BusyIndex);
+
+private:
+	FWorkerGroup m_Groups[(int32)EGroup::Num];
+	// I/O 线程组按需创建，没有网络流时不占线程
+	FCriticalSection m_IOGroupMutex;
+	TAtomic<bool> m_bIOGroupStarted = false;
+};
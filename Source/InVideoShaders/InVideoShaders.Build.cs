@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+// InVideo 的着色器目录映射和全局着色器类型，必须在 PostConfigInit 阶段加载，早于全局着色器编译
+public class InVideoShaders : ModuleRules
+{
+  public InVideoShaders(ReadOnlyTargetRules Target) : base(Target)
+  {
+    PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+    PublicDependencyModuleNames.AddRange(
+      new string[]
+      {
+        "Core",
+        "RHI",
+        "RenderCore"
+      }
+      );
+
+    PrivateDependencyModuleNames.AddRange(
+      new string[]
+      {
+        "Projects"
+      }
+      );
+  }
+}
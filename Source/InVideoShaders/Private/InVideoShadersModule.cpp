@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InVideoConvertShader.h"
+#include "Modules/ModuleManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "ShaderCore.h"
+
+IMPLEMENT_GLOBAL_SHADER(FInVideoConvertPS, "/Plugin/InVideo/Private/InVideoConvert.usf", "MainPS", SF_Pixel);
+
+/**
+ * 注册 /Plugin/InVideo 着色器目录和全局着色器类型。两者都必须在全局着色器编译之前就绪，所以单独成模块在 PostConfigInit 加载，
+ * InVideo 运行时模块（OpenCV、工作线程池等）仍按 Default 阶段加载。
+ */
+class FInVideoShadersModule : public IModuleInterface
+{
+public:
+	virtual void StartupModule() override
+	{
+		const FString PluginDir = IPluginManager::Get().FindPlugin(TEXT("InVideo"))->GetBaseDir();
+		AddShaderSourceDirectoryMapping(TEXT("/Plugin/InVideo"), FPaths::Combine(PluginDir, TEXT("Shaders")));
+	}
+};
+
+IMPLEMENT_MODULE(FInVideoShadersModule, InVideoShaders)
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+
+// YUV/BGR 平面转换到 RGBA 的像素着色器。全局着色器类型需在 PostConfigInit 注册，放在着色器模块里
+class FInVideoConvertPS : public FGlobalShader
+{
+public:
+	DECLARE_EXPORTED_GLOBAL_SHADER(FInVideoConvertPS, INVIDEOSHADERS_API);
+	SHADER_USE_PARAMETER_STRUCT(FInVideoConvertPS, FGlobalShader);
+
+	// 0 = PackedBGR, 1 = I420, 2 = NV12，与 EInVideoPlaneLayout 一致
+	class FLayoutDim : SHADER_PERMUTATION_INT("INVIDEO_PLANE_LAYOUT", 3);
+	using FPermutationDomain = TShaderPermutationDomain<FLayoutDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, INVIDEOSHADERS_API)
+		SHADER_PARAMETER_TEXTURE(Texture2D, PlaneY)
+		SHADER_PARAMETER_TEXTURE(Texture2D, PlaneU)
+		SHADER_PARAMETER_TEXTURE(Texture2D, PlaneV)
+		SHADER_PARAMETER_SAMPLER(SamplerState, PlaneSampler)
+		SHADER_PARAMETER(FIntPoint, SourceSize)
+		SHADER_PARAMETER(FVector2f, InvOutputSize)
+		SHADER_PARAMETER(uint32, bBT709)
+		RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+};